@@ -5,5 +5,44 @@
 #include <cachesim/cache_.h>
 #include <cachesim/direct_cache.h>
 #include <cachesim/set_associative_cache.h>
+#include <cachesim/skewed_associative_cache.h>
+
+#include <memory>
+
+namespace cachesim {
+
+// enum cache_type
+// Defines the cache types, as numbered in the config file.
+enum cache_type { DIRECT, SET_ASSOCIATIVE, SKEWED_ASSOCIATIVE };
+
+// Returns a new cache of the given type, or nullptr if the type or the index
+// policy doesn't exist.
+// The index policy is ignored by skewed-associative caches, which always skew
+// their ways.
+// The cache ctor will throw if the sizes are not valid.
+inline std::unique_ptr<cache> make_cache(const std::size_t& size,
+                                         const int& type,
+                                         const std::size_t& line_size,
+                                         const int& policy, const int& index,
+                                         std::ostream& os, const bool& hex) {
+  if (index < MODULO || index > PRIME_MODULO) {
+    return nullptr;
+  }
+  switch (type) {
+    case DIRECT:
+      return std::make_unique<direct_cache>(size, line_size, policy, os, hex,
+                                            index);
+    case SET_ASSOCIATIVE:
+      return std::make_unique<set_associative_cache>(size, line_size, policy,
+                                                     os, hex, index);
+    case SKEWED_ASSOCIATIVE:
+      return std::make_unique<skewed_associative_cache>(size, line_size,
+                                                        policy, os, hex);
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace cachesim
 
 #endif  // CACHESIM_CACHE_H_
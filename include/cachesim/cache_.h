@@ -2,10 +2,15 @@
 #ifndef CACHESIM_CACHE__H_
 #define CACHESIM_CACHE__H_
 
+#include <cachesim/conflict_stats.h>
 #include <cachesim/error.h>
+#include <cachesim/event_log.h>
+#include <cachesim/interval_stats.h>
+#include <cachesim/limits.h>
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <stdexcept>
@@ -17,11 +22,23 @@ namespace cachesim {
 // Defines the emplace algorithm to use.
 enum emplace_policy { LRU, MRU };
 
+// type address
+// Defines an allocated address, wide enough for 64-bit traces.
+using address = std::int64_t;
+
 // constant empty_space
 // Defines an empty space in cache.
-constexpr int empty_space = -1;
+constexpr address empty_space = -1;
+
+using cache_set = std::vector<address>;  // just to make things simpler.
 
-using cache_set = std::vector<int>;  // just to make things simpler.
+// Returns whether a cache of the given sizes can be built: both sizes must be
+// powers of 2, and the line size can't be bigger than the total size.
+inline bool is_valid_size(const std::size_t& size,
+                          const std::size_t& line_size) noexcept {
+  return size && !(size & (size - 1)) && line_size &&
+         !(line_size & (line_size - 1)) && line_size <= size;
+}
 
 // class cache
 // Abstract definition of a cache.
@@ -37,36 +54,49 @@ class cache {
   std::size_t size() const noexcept;
   std::size_t line_size() const noexcept;
   std::size_t count() const noexcept;
-  int hit_count() const noexcept;
-  int miss_count() const noexcept;
+  unsigned address_bits() const noexcept;
+  std::uint64_t hit_count() const noexcept;
+  std::uint64_t miss_count() const noexcept;
   // mutators
+  void attach_log(event_log* log) noexcept;
+  void attach_stats(interval_stats* stats) noexcept;
+  void attach_conflicts(conflict_stats* conflicts) noexcept;
+  void set_quiet(const bool& quiet) noexcept;
+  void set_address_bits(const unsigned& bits);
   virtual void clear() = 0;
   virtual void resize(const std::size_t& size,
                       const std::size_t& line_size) = 0;
-  virtual void allocate(const int& value) = 0;
+  virtual bool allocate(const address& value) = 0;
 
  protected:
-  virtual int get_id(const int& value) const noexcept = 0;
+  virtual int get_id(const address& value) const noexcept = 0;
   bool is_pow2(const std::size_t& n) const noexcept;
-  void print_line(const int& dir, const bool& hit_miss, const int& id,
-                  const int& old_dir) const noexcept;
+  void record(const address& dir, const bool& hit_miss, const int& id,
+              const address& old_dir, const address& evicted);
+  void print_line(const address& dir, const bool& hit_miss, const int& id,
+                  const address& old_dir) const noexcept;
   void check_size() const;
   void set_size(const std::size_t& size, const std::size_t& line_size);
   // member variables
-  std::size_t size_;         // cache size
-  std::size_t line_size_;    // cache line size
-  std::size_t items_count_;  // max cache item count
-  int hit_count_;            // cache hit count
-  int miss_count_;           // cache miss count
-  emplace_policy policy_;    // cache emplace policy
-  std::ostream& os_;         // output stream
-  bool hex_;                 // output hex value for addresses
+  std::size_t size_;           // cache size
+  std::size_t line_size_;      // cache line size
+  std::size_t items_count_;    // max cache item count
+  std::uint64_t hit_count_;    // cache hit count
+  std::uint64_t miss_count_;   // cache miss count
+  emplace_policy policy_;      // cache emplace policy
+  std::ostream& os_;           // output stream
+  bool hex_;                   // output hex value for addresses
+  event_log* log_;             // event log replacing the output, if any
+  interval_stats* stats_;      // windowed statistics, if any
+  conflict_stats* conflicts_;  // conflict analysis, if any
+  bool quiet_;                 // don't report allocation attempts
+  unsigned address_bits_;      // bits of the allocated addresses
 };
 
 // Default ctor
 // Sets the items count to 1 because the line size cannot be bigger than the
 // total cache size.
-cache::cache()
+inline cache::cache()
     : size_(1),
       line_size_(1),
       items_count_(1),
@@ -74,84 +104,152 @@ cache::cache()
       miss_count_(0),
       policy_(LRU),
       os_(std::cout),
-      hex_(false) {}
+      hex_(false),
+      log_(nullptr),
+      stats_(nullptr),
+      conflicts_(nullptr),
+      quiet_(false),
+      address_bits_(limits::address_bits) {}
 
 // Explicit ctor
 // Initializes the items count to size / line size
 // This is necessary to know the max amount of items that the cache can hold.
 // Converts the policy integer into an enum value using a static cast.
-// It will check if the size and line size are powers of 2.
-cache::cache(const std::size_t& size, const std::size_t& line_size,
-             const int& policy, std::ostream& os, const bool& hex)
+// It will check if the size and line size are powers of 2 before dividing.
+inline cache::cache(const std::size_t& size, const std::size_t& line_size,
+                    const int& policy, std::ostream& os, const bool& hex)
     : size_(size),
       line_size_(line_size),
-      items_count_(size / line_size_),
+      items_count_(0),
       hit_count_(0),
       miss_count_(0),
       policy_(static_cast<emplace_policy>(policy)),
       os_(os),
-      hex_(hex) {
+      hex_(hex),
+      log_(nullptr),
+      stats_(nullptr),
+      conflicts_(nullptr),
+      quiet_(false),
+      address_bits_(limits::address_bits) {
   check_size();
+  items_count_ = size_ / line_size_;
 }
 
 // Returns the cache total size (Represented in bytes).
-std::size_t cache::size() const noexcept { return size_; }
+inline std::size_t cache::size() const noexcept { return size_; }
 
 // Returns the cache line size (Represented in bytes).
-std::size_t cache::line_size() const noexcept { return line_size_; }
+inline std::size_t cache::line_size() const noexcept { return line_size_; }
 
 // Returns the max amount of items that the cache can hold.
-std::size_t cache::count() const noexcept { return items_count_; }
+inline std::size_t cache::count() const noexcept { return items_count_; }
+
+// Returns the bits of the allocated addresses the tags are sized for.
+inline unsigned cache::address_bits() const noexcept { return address_bits_; }
 
 // Returns the amount of hits performed.
-int cache::hit_count() const noexcept { return hit_count_; }
+inline std::uint64_t cache::hit_count() const noexcept {
+  return hit_count_;
+}
 
 // Returns the amount of misses performed.
-int cache::miss_count() const noexcept { return miss_count_; }
+inline std::uint64_t cache::miss_count() const noexcept {
+  return miss_count_;
+}
+
+// Sends every following allocation attempt to the given event log instead of
+// printing it. A null log restores the printed output.
+// The log is not owned by the cache.
+inline void cache::attach_log(event_log* log) noexcept { log_ = log; }
+
+// Counts every following allocation attempt into the given windowed
+// statistics. A null pointer stops counting.
+// The statistics are not owned by the cache.
+inline void cache::attach_stats(interval_stats* stats) noexcept {
+  stats_ = stats;
+}
+
+// Counts the misses and evictions of every following allocation attempt into
+// the given conflict analysis. A null pointer stops counting.
+// The analysis is not owned by the cache.
+inline void cache::attach_conflicts(conflict_stats* conflicts) noexcept {
+  conflicts_ = conflicts;
+}
+
+// Sets whether allocation attempts are reported at all. A quiet cache only
+// keeps its counters, which is what callers reading the allocate() result
+// want.
+inline void cache::set_quiet(const bool& quiet) noexcept { quiet_ = quiet; }
+
+// Sizes the tags for allocated addresses of the given bits, which empties the
+// cache. Tags are sized for the simulated 16-bit memory by default; a wider
+// address still widens them, once, when it is allocated.
+inline void cache::set_address_bits(const unsigned& bits) {
+  address_bits_ = bits;
+  resize(size_, line_size_);
+}
 
 // Returns wheter a certain positive number is a power of two,
 // that is, it can be expressed as 2^n.
 // This is used to check whether the size values are valid.
 // NOTE: works for n>=0, returns false for 0.
-bool cache::is_pow2(const std::size_t& n) const noexcept {
+inline bool cache::is_pow2(const std::size_t& n) const noexcept {
   return n && !(n & (n - 1));
 }
 
+// Reports the current allocation attempt, either to the attached event log or
+// as a printed line. Windowed statistics and conflicts are counted even for
+// quiet caches.
+inline void cache::record(const address& dir, const bool& hit_miss,
+                          const int& id, const address& old_dir,
+                          const address& evicted) {
+  if (stats_) {
+    stats_->record(dir, hit_miss, evicted != empty_space);
+  }
+  if (conflicts_) {
+    conflicts_->record(dir, hit_miss, id, evicted);
+  }
+  if (quiet_) {
+    return;
+  }
+  if (log_) {
+    log_->push({dir, old_dir, evicted, static_cast<std::uint32_t>(id),
+                hit_miss});
+  } else {
+    print_line(dir, hit_miss, id, old_dir);
+  }
+}
+
 // Prints a formatted line with the current allocation attempt.
 // It can output to std::cout or to an std::ofstream depending of the value
 // received in the ctor.
-void cache::print_line(const int& dir, const bool& hit_miss, const int& id,
-                       const int& old_dir) const noexcept {
-  os_.width(25);
-  os_ << (hex_ ? std::hex : std::dec) << dir;
-  os_.width(20);
-  os_ << std::dec << hit_miss;
-  os_.width(10);
-  os_ << id;
-  os_.width(25);
-  os_ << (hex_ ? std::hex : std::dec) << old_dir;
-  os_.width(25);
-  os_ << dir << std::dec << '\n';
+inline void cache::print_line(const address& dir, const bool& hit_miss,
+                              const int& id,
+                              const address& old_dir) const noexcept {
+  print_event(os_, {dir, old_dir, empty_space, static_cast<std::uint32_t>(id),
+                    hit_miss},
+              hex_);
 }
 
 // Checks whether both total and line sizes are a power of 2 and that the line
 // size smaller or equal to the total size.
 // It is used to check the values after ctor initialization or resizing.
-void cache::check_size() const {
-  if (!is_pow2(size_) || !is_pow2(line_size_) || line_size_ > size_) {
+inline void cache::check_size() const {
+  if (!is_valid_size(size_, line_size_)) {
     throw std::invalid_argument(error::invalid_cache_size);
   }
 }
 
 // Resizes the cache, clearing all current data and checks whether the
 // parameters are valid.
-void cache::set_size(const std::size_t& size, const std::size_t& line_size) {
+inline void cache::set_size(const std::size_t& size,
+                            const std::size_t& line_size) {
   size_ = size;
   line_size_ = line_size;
-  items_count_ = size / line_size;
   hit_count_ = 0;
   miss_count_ = 0;
   check_size();
+  items_count_ = size / line_size;
 }
 
 }  // namespace cachesim
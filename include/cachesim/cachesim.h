@@ -0,0 +1,84 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_CACHESIM_H_
+#define CACHESIM_CACHESIM_H_
+
+// C interface of libcachesim.
+// Caches are created from a config struct and driven with batches of
+// addresses, without any file or text output. A cache must not be used by
+// two threads at once, different caches can.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define CACHESIM_API __attribute__((visibility("default")))
+#else
+#define CACHESIM_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Version of this interface. It changes only when the structs or the
+// functions below change in an incompatible way.
+#define CACHESIM_API_VERSION 1
+
+// Status returned by every function that can fail.
+typedef enum cachesim_status {
+  CACHESIM_OK = 0,
+  CACHESIM_INVALID_ARGUMENT = 1,  // null pointer or address over 2^63 - 1
+  CACHESIM_INVALID_CONFIG = 2,    // unknown type, policy, index or bad sizes
+  CACHESIM_OUT_OF_MEMORY = 3,
+  CACHESIM_INTERNAL_ERROR = 4  // unexpected failure inside the library
+} cachesim_status;
+
+// Cache configuration, numbered as in the config file.
+typedef struct cachesim_config {
+  uint64_t size;       // cache size in bytes, a power of 2
+  uint64_t line_size;  // line size in bytes, a power of 2
+  uint32_t type;       // 0 direct, 1 set-associative, 2 skewed-associative
+  uint32_t policy;     // 0 LRU, 1 MRU
+  uint32_t index;      // 0 modulo, 1 XOR fold, 2 prime modulo
+} cachesim_config;
+
+// Counters of the allocations since the cache was created or reset.
+typedef struct cachesim_counters {
+  uint64_t hits;
+  uint64_t misses;
+} cachesim_counters;
+
+// Opaque simulated cache.
+typedef struct cachesim_cache cachesim_cache;
+
+// Returns CACHESIM_API_VERSION of the library actually loaded.
+CACHESIM_API int cachesim_api_version(void);
+
+// Creates an empty cache, stored in *cache.
+CACHESIM_API cachesim_status cachesim_create(const cachesim_config* config,
+                                             cachesim_cache** cache);
+
+// Allocates n addresses in order, writing 1 (hit) or 0 (miss) for every one
+// of them in results, which may be null when only the counters are wanted.
+// The batch is checked first: if any address is over 2^63 - 1 nothing is
+// allocated.
+CACHESIM_API cachesim_status cachesim_simulate_batch(cachesim_cache* cache,
+                                                     const uint64_t* addresses,
+                                                     size_t n,
+                                                     uint8_t* results);
+
+// Stores the counters of the cache in *counters.
+CACHESIM_API cachesim_status cachesim_get_counters(
+    const cachesim_cache* cache, cachesim_counters* counters);
+
+// Empties the cache and zeroes its counters.
+CACHESIM_API cachesim_status cachesim_reset(cachesim_cache* cache);
+
+// Destroys a cache. Null is ignored.
+CACHESIM_API void cachesim_destroy(cachesim_cache* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CACHESIM_CACHESIM_H_
@@ -0,0 +1,118 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_CONFLICT_STATS_H_
+#define CACHESIM_CONFLICT_STATS_H_
+
+#include <cachesim/sketch.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cachesim {
+
+// Max number of items reported by conflict_stats.
+constexpr const std::size_t max_conflicts = 1024;
+
+// struct block_pair
+// Two blocks which evicted each other, the lowest one first.
+struct block_pair {
+  std::int64_t first;   // lowest block
+  std::int64_t second;  // highest block
+};
+
+// class conflict_stats
+// Finds the causes of the misses of a cache in bounded memory: the blocks
+// missing most often, the sets evicting most often and the pairs of blocks
+// evicting each other most often, k of each.
+// Every one of them is counted by a heavy_hitters structure, so the memory
+// used doesn't grow with the allocations and every miss has the same cost.
+// Counts are estimates which may exceed the actual ones, never fall short.
+class conflict_stats {
+ public:
+  // ctor
+  explicit conflict_stats(const std::size_t& k);
+  // accessors
+  std::uint64_t miss_count() const noexcept;
+  std::uint64_t eviction_count() const noexcept;
+  std::vector<heavy_hitter<std::int64_t>> missing_blocks() const;
+  std::vector<heavy_hitter<std::uint32_t>> thrashed_sets() const;
+  std::vector<heavy_hitter<block_pair>> evicting_pairs() const;
+  // mutators
+  void record(const std::int64_t& dir, const bool& hit, const int& id,
+              const std::int64_t& evicted);
+  void clear() noexcept;
+
+ private:
+  // member variables
+  heavy_hitters<std::int64_t> blocks_;  // missing blocks
+  heavy_hitters<std::uint32_t> sets_;   // sets of the evictions
+  heavy_hitters<block_pair> pairs_;     // blocks and the blocks they evicted
+};
+
+// Explicit ctor
+// Reports up to max_conflicts items of each kind.
+inline conflict_stats::conflict_stats(const std::size_t& k)
+    : blocks_(std::min(k, max_conflicts)),
+      sets_(std::min(k, max_conflicts)),
+      pairs_(std::min(k, max_conflicts)) {}
+
+// Returns the amount of misses recorded.
+inline std::uint64_t conflict_stats::miss_count() const noexcept {
+  return blocks_.total();
+}
+
+// Returns the amount of evictions recorded.
+inline std::uint64_t conflict_stats::eviction_count() const noexcept {
+  return sets_.total();
+}
+
+// Returns the blocks missing most often, most misses first.
+inline std::vector<heavy_hitter<std::int64_t>> conflict_stats::missing_blocks()
+    const {
+  return blocks_.top();
+}
+
+// Returns the sets evicting most often, most evictions first.
+inline std::vector<heavy_hitter<std::uint32_t>> conflict_stats::thrashed_sets()
+    const {
+  return sets_.top();
+}
+
+// Returns the pairs of blocks evicting each other most often, most evictions
+// first. The evictions of both blocks of a pair are added together.
+inline std::vector<heavy_hitter<block_pair>> conflict_stats::evicting_pairs()
+    const {
+  return pairs_.top();
+}
+
+// Counts an allocation attempt. Hits are ignored; a miss counts the missing
+// block, and if a block was evicted, the set and the pair of blocks as well.
+inline void conflict_stats::record(const std::int64_t& dir, const bool& hit,
+                                   const int& id,
+                                   const std::int64_t& evicted) {
+  if (hit) {
+    return;
+  }
+  blocks_.add(static_cast<std::uint64_t>(dir), dir);
+  if (evicted < 0) {
+    return;
+  }
+  auto set{static_cast<std::uint32_t>(id)};
+  block_pair pair{std::min(dir, evicted), std::max(dir, evicted)};
+  sets_.add(set, set);
+  pairs_.add(mix_key(static_cast<std::uint64_t>(pair.first)) ^
+                 static_cast<std::uint64_t>(pair.second),
+             pair);
+}
+
+// Forgets every count.
+inline void conflict_stats::clear() noexcept {
+  blocks_.clear();
+  sets_.clear();
+  pairs_.clear();
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_CONFLICT_STATS_H_
@@ -3,76 +3,125 @@
 #define CACHESIM_DIRECT_CACHE_H_
 
 #include <cachesim/cache_.h>
+#include <cachesim/set_index.h>
+#include <cachesim/tag_array.h>
+#include <cachesim/victim_buffer.h>
 
 namespace cachesim {
 
 // class direct_cache
 // Represents a direct-mapped cache.
+// Lines only keep the tag of their address, sized for the address bits of
+// the cache.
+// A victim or miss cache may be attached, probed on every miss. Misses found
+// in it still count as misses of the cache, and are counted by the buffer.
 // Inherits from cache.
 class direct_cache final : public cache {
  public:
   // ctor
   direct_cache();
   explicit direct_cache(const std::size_t& size, const std::size_t& line_size,
-                        const int& policy, std::ostream& os, const bool& hex);
+                        const int& policy, std::ostream& os, const bool& hex,
+                        const int& index = MODULO);
   ~direct_cache() = default;
+  // accessors
+  const victim_buffer& buffer() const noexcept;
   // mutators
+  void set_buffer(const std::size_t& lines, const buffer_mode& mode);
   void clear() override final;
   void resize(const std::size_t& size,
               const std::size_t& line_size) override final;
-  void allocate(const int& value) override final;
+  bool allocate(const address& value) override final;
 
  private:
-  int get_id(const int& value) const noexcept override final;
+  int get_id(const address& value) const noexcept override final;
+  address line(const int& id) const noexcept;
   // member variables
-  cache_set items_;  // cache items
+  set_index index_;       // address to line mapping
+  tag_array tags_;        // tags of the cache items
+  victim_buffer buffer_;  // victim or miss cache, if it has any line
 };
 
 // Default ctor
 // Creates a 1 item cache filled with an empty space.
-direct_cache::direct_cache() : cache(), items_(1, empty_space) {}
+inline direct_cache::direct_cache() : cache(), index_(), tags_(), buffer_() {}
 
 // Explicit ctor
-// Creates an n item cache filled with empty spaces.
+// Creates an n item cache filled with empty spaces, mapping addresses to lines
+// with the given index policy.
 // The sizes check is performed under the cache ctor.
-direct_cache::direct_cache(const std::size_t& size,
-                           const std::size_t& line_size, const int& policy,
-                           std::ostream& os, const bool& hex)
+inline direct_cache::direct_cache(const std::size_t& size,
+                                  const std::size_t& line_size,
+                                  const int& policy, std::ostream& os,
+                                  const bool& hex, const int& index)
     : cache(size, line_size, policy, os, hex),
-      items_(items_count_, empty_space) {}
+      index_(static_cast<index_policy>(index), items_count_),
+      tags_(items_count_, index_.tag_bits(address_bits_)),
+      buffer_() {}
 
-// Wipes all items and replaces it with empty spaces.
-void direct_cache::clear() {
-  std::fill(items_.begin(), items_.end(), empty_space);
+// Returns the victim or miss cache.
+inline const victim_buffer& direct_cache::buffer() const noexcept {
+  return buffer_;
+}
+
+// Attaches an empty victim or miss cache of the given lines, replacing the
+// current one. A buffer without lines is never probed.
+inline void direct_cache::set_buffer(const std::size_t& lines,
+                                     const buffer_mode& mode) {
+  buffer_ = victim_buffer(lines, mode);
+}
+
+// Wipes all items and replaces it with empty spaces, zeroing the counters.
+inline void direct_cache::clear() {
+  tags_.clear();
+  buffer_.clear();
+  hit_count_ = 0;
+  miss_count_ = 0;
 }
 
 // Resizes the cache and the vector after checking the sizes.
-void direct_cache::resize(const std::size_t& size,
-                          const std::size_t& line_size) {
+inline void direct_cache::resize(const std::size_t& size,
+                                 const std::size_t& line_size) {
   set_size(size, line_size);
-  clear();
-  items_.resize(size / line_size, empty_space);
+  index_ = set_index(index_.policy(), items_count_);
+  tags_ = tag_array(items_count_, index_.tag_bits(address_bits_));
+  buffer_.clear();
 }
 
 // Puts an element in its belonged place inside cache.
-// Also prints the current allocation attempt.
+// Also prints the current allocation attempt and returns whether it was a hit.
+// A miss probes the victim or miss cache, if any, with the evicted line.
 // This is the main interaction function.
-void direct_cache::allocate(const int& value) {
+inline bool direct_cache::allocate(const address& value) {
   auto id{get_id(value)};
-  auto found{items_[id] == value};
+  auto tag{index_.tag(value)};
+  auto found{tags_.valid(id) && tags_[id] == tag};
+  auto old{line(id)};
 
-  print_line(value, found, id, items_[id]);
+  record(value, found, id, old, (found ? empty_space : old));
   if (found) {
     ++hit_count_;
   } else {
-    items_[id] = value;
+    if (buffer_.size()) {
+      buffer_.probe(value, old);
+    }
+    tags_.set(id, tag);
     ++miss_count_;
   }
+
+  return found;
 }
 
 // Returns the id of the position in which the new ellement should be allocated.
-int direct_cache::get_id(const int& value) const noexcept {
-  return value % (items_count_);
+inline int direct_cache::get_id(const address& value) const noexcept {
+  return index_(value);
+}
+
+// Returns the address held in a line, or an empty space.
+inline address direct_cache::line(const int& id) const noexcept {
+  return tags_.valid(id)
+             ? static_cast<address>(index_.rebuild(tags_[id], id))
+             : empty_space;
 }
 
 }  // namespace cachesim
@@ -24,6 +24,41 @@ constexpr const char* invalid_cache_type =
 
 // Invalid cache size output.
 constexpr const char* invalid_cache_size = "Error: Invalid cache size.\n";
+
+// Failed to start the server output.
+constexpr const char* failed_to_serve = "Error: Failed to listen on ";
+
+// Invalid event log output.
+constexpr const char* invalid_event_log =
+    "Error: Invalid binary event log read.\n";
+
+// Invalid shared cache type output.
+constexpr const char* invalid_shared_cache_type =
+    "Error: Several data files need a set-associative cache.\n";
+
+// Tenant options with a single data file output.
+constexpr const char* invalid_tenant_options =
+    "Error: Options -r, -m and -i need several data files.\n";
+
+// Windowed statistics options without a window output.
+constexpr const char* invalid_window_options =
+    "Error: Options -p and -s need a window given with -w.\n";
+
+// Invalid way mask output.
+constexpr const char* invalid_way_mask =
+    "Error: Way mask allows no way of the cache.\n";
+
+// Invalid TLB configuration file output.
+constexpr const char* invalid_tlb_config =
+    "Error: Invalid input read in TLB config file.\n";
+
+// TLB with several data files output.
+constexpr const char* invalid_shared_tlb =
+    "Error: The TLB is only simulated with a single data file.\n";
+
+// Victim or miss cache without a direct-mapped cache output.
+constexpr const char* invalid_buffer_cache_type =
+    "Error: Victim and miss caches need a direct-mapped cache.\n";
 }  // namespace error
 }  // namespace cachesim
 
@@ -0,0 +1,253 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_EVENT_LOG_H_
+#define CACHESIM_EVENT_LOG_H_
+
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cachesim {
+
+// struct event
+// Fixed-size record of a single allocation attempt.
+struct event {
+  std::int64_t address;    // allocated address
+  std::int64_t old_value;  // cache line content before the allocation
+  std::int64_t evicted;    // address evicted by the allocation
+  std::uint32_t set_id;    // set (or line) id of the address
+  std::uint32_t hit;       // 1 for a hit, 0 for a miss
+};
+
+static_assert(sizeof(event) == 32, "event records must stay 32 bytes long");
+
+// enum log_format
+// Defines the encoding of the event log.
+enum log_format { CSV, BINARY };
+
+// Binary event log header: magic number, version and record size.
+constexpr const char event_log_magic[4] = {'C', 'S', 'E', 'V'};
+constexpr const std::uint32_t event_log_version = 1;
+
+// Default number of events held by each block of the event log.
+constexpr const std::size_t event_log_block_size = 1 << 16;
+
+// class event_log
+// Records allocation events into two large blocks. While one block is being
+// filled by the simulation, a background thread writes the other one to the
+// output stream as CSV or as raw event records.
+class event_log {
+ public:
+  // ctor
+  explicit event_log(std::ostream& os, const log_format& format,
+                     const std::size_t& block_size = event_log_block_size);
+  event_log(const event_log&) = delete;
+  event_log& operator=(const event_log&) = delete;
+  // dtor
+  ~event_log();
+  // accessors
+  std::size_t size() const noexcept;
+  // mutators
+  void push(const event& e);
+  void close();
+
+ private:
+  void submit();
+  void run();
+  void write(const event* block, const std::size_t& n);
+  // member variables
+  std::ostream& os_;               // output stream
+  log_format format_;              // output encoding
+  std::vector<event> blocks_[2];   // double buffer
+  std::size_t active_;             // block being filled
+  std::size_t fill_;               // events in the active block
+  std::size_t pending_;            // events waiting for the writer
+  std::size_t submitted_;          // block waiting for the writer
+  std::size_t total_;              // events recorded
+  bool done_;                      // no more blocks will be submitted
+  std::string text_;               // CSV formatting buffer
+  std::mutex mutex_;               // guards the writer state
+  std::condition_variable ready_;  // signals changes of the writer state
+  std::thread writer_;             // background writer
+};
+
+// Explicit ctor
+// Writes the log header and starts the background writer.
+inline event_log::event_log(std::ostream& os, const log_format& format,
+                            const std::size_t& block_size)
+    : os_(os),
+      format_(format),
+      blocks_{std::vector<event>(block_size), std::vector<event>(block_size)},
+      active_(0),
+      fill_(0),
+      pending_(0),
+      submitted_(0),
+      total_(0),
+      done_(false) {
+  if (format_ == BINARY) {
+    std::uint32_t record_size = sizeof(event);
+
+    os_.write(event_log_magic, sizeof(event_log_magic));
+    os_.write(reinterpret_cast<const char*>(&event_log_version),
+              sizeof(event_log_version));
+    os_.write(reinterpret_cast<const char*>(&record_size),
+              sizeof(record_size));
+  } else {
+    os_ << "address,hit,set_id,evicted\n";
+  }
+  writer_ = std::thread(&event_log::run, this);
+}
+
+// Dtor
+// Writes whatever is left in the blocks.
+inline event_log::~event_log() { close(); }
+
+// Returns the amount of events recorded.
+inline std::size_t event_log::size() const noexcept { return total_; }
+
+// Appends an event to the active block, handing the block to the writer once
+// it is full.
+inline void event_log::push(const event& e) {
+  blocks_[active_][fill_++] = e;
+  ++total_;
+  if (fill_ == blocks_[active_].size()) {
+    submit();
+  }
+}
+
+// Submits the partially filled block and waits for the writer to finish.
+// The log can't be used after it has been closed.
+inline void event_log::close() {
+  if (!writer_.joinable()) {
+    return;
+  }
+  if (fill_) {
+    submit();
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return pending_ == 0; });
+    done_ = true;
+  }
+  ready_.notify_all();
+  writer_.join();
+  os_.flush();
+}
+
+// Hands the active block to the writer, waiting for the writer to release the
+// other block first, and starts filling the other block.
+inline void event_log::submit() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return pending_ == 0; });
+    pending_ = fill_;
+    submitted_ = active_;
+  }
+  ready_.notify_all();
+  active_ ^= 1;
+  fill_ = 0;
+}
+
+// Writer thread loop.
+inline void event_log::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  for (;;) {
+    ready_.wait(lock, [this] { return pending_ || done_; });
+    if (!pending_) {
+      return;
+    }
+    auto block{blocks_[submitted_].data()};
+    auto n{pending_};
+    lock.unlock();
+    write(block, n);
+    lock.lock();
+    pending_ = 0;
+    ready_.notify_all();
+  }
+}
+
+// Writes n events to the output stream in the log format.
+inline void event_log::write(const event* block, const std::size_t& n) {
+  if (format_ == BINARY) {
+    os_.write(reinterpret_cast<const char*>(block), n * sizeof(event));
+    return;
+  }
+
+  char line[96];
+  text_.clear();
+  for (std::size_t i = 0; i < n; ++i) {
+    auto end{line + sizeof(line)};
+    auto p{std::to_chars(line, end, block[i].address).ptr};
+    *p++ = ',';
+    *p++ = block[i].hit ? '1' : '0';
+    *p++ = ',';
+    p = std::to_chars(p, end, block[i].set_id).ptr;
+    *p++ = ',';
+    p = std::to_chars(p, end, block[i].evicted).ptr;
+    *p++ = '\n';
+    text_.append(line, p);
+  }
+  os_.write(text_.data(), text_.size());
+}
+
+// Outputs the event as a formatted line of the allocation table.
+// Empty spaces are printed in hex with the 32-bit width they always had.
+inline void print_event(std::ostream& os, const event& e, const bool& hex) {
+  os.width(25);
+  os << (hex ? std::hex : std::dec) << e.address;
+  os.width(20);
+  os << std::dec << e.hit;
+  os.width(10);
+  os << e.set_id;
+  os.width(25);
+  if (hex && e.old_value < 0) {
+    os << std::hex << static_cast<std::uint32_t>(e.old_value);
+  } else {
+    os << (hex ? std::hex : std::dec) << e.old_value;
+  }
+  os.width(25);
+  os << e.address << std::dec << '\n';
+}
+
+// Reads the header of a binary event log.
+// Returns false if the stream doesn't hold a binary event log.
+inline bool read_event_log_header(std::istream& is) {
+  char magic[sizeof(event_log_magic)];
+  std::uint32_t version = 0;
+  std::uint32_t record_size = 0;
+
+  is.read(magic, sizeof(magic));
+  is.read(reinterpret_cast<char*>(&version), sizeof(version));
+  is.read(reinterpret_cast<char*>(&record_size), sizeof(record_size));
+
+  return is && !std::memcmp(magic, event_log_magic, sizeof(magic)) &&
+         version == event_log_version && record_size == sizeof(event);
+}
+
+// Outputs the allocation table stored in a binary event log whose header was
+// already read, passing every event to the given visitor as well.
+template <typename Visitor>
+void print_event_log(std::istream& is, std::ostream& os, const bool& hex,
+                     Visitor visit) {
+  std::vector<event> block(event_log_block_size);
+  while (is) {
+    is.read(reinterpret_cast<char*>(block.data()),
+            block.size() * sizeof(event));
+    auto n{static_cast<std::size_t>(is.gcount()) / sizeof(event)};
+    for (std::size_t i = 0; i < n; ++i) {
+      print_event(os, block[i], hex);
+      visit(block[i]);
+    }
+  }
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_EVENT_LOG_H_
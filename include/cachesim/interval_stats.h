@@ -0,0 +1,198 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_INTERVAL_STATS_H_
+#define CACHESIM_INTERVAL_STATS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace cachesim {
+
+// struct interval
+// Counters of a window of consecutive allocations.
+struct interval {
+  std::uint64_t first;      // position of the first allocation of the window
+  std::uint32_t accesses;   // allocations in the window
+  std::uint32_t hits;       // cache hits
+  std::uint32_t misses;     // cache misses
+  std::uint32_t evictions;  // lines evicted
+  std::uint32_t unique;     // distinct addresses allocated
+  bool phase_change;        // the window starts a new phase
+};
+
+// Default number of windows kept by interval_stats.
+constexpr const std::size_t interval_capacity = 1 << 16;
+
+// Max number of allocations per window of interval_stats.
+constexpr const std::size_t max_window = 1 << 20;
+
+// class interval_stats
+// Splits the allocations into windows of n allocations and keeps the counters
+// of every window in a ring of preallocated windows, so that only the latest
+// windows are kept once the ring is full.
+// When a threshold is given, a window whose hit rate differs from the mean of
+// the current phase by more than the threshold starts a new phase.
+class interval_stats {
+ public:
+  // ctor
+  explicit interval_stats(const std::size_t& window,
+                          const double& threshold = 0,
+                          const std::size_t& capacity = interval_capacity);
+  // accessors
+  std::size_t size() const noexcept;
+  const interval& operator[](const std::size_t& i) const noexcept;
+  std::size_t phase_count() const noexcept;
+  void write_csv(std::ostream& os) const;
+  // mutators
+  void record(const std::int64_t& dir, const bool& hit, const bool& evicted);
+  void finish();
+
+ private:
+  // struct slot
+  // Entry of the table of the addresses seen in the current window.
+  struct slot {
+    std::int64_t dir;
+    std::uint32_t epoch;
+  };
+  void touch(const std::int64_t& dir);
+  void close_window();
+  // member variables
+  std::size_t window_;          // allocations per window
+  double threshold_;            // hit rate change starting a phase
+  std::vector<interval> ring_;  // kept windows
+  std::size_t head_;            // position of the oldest window
+  std::size_t count_;           // windows kept
+  interval current_;            // window being recorded
+  std::vector<slot> seen_;      // addresses seen, by window epoch
+  std::uint32_t epoch_;         // epoch of the current window
+  double phase_rate_;           // mean hit rate of the current phase
+  std::size_t phase_windows_;   // windows in the current phase
+  std::size_t phases_;          // phases detected
+};
+
+// Explicit ctor
+// Windows hold from 1 to max_window allocations. The table of the addresses
+// seen holds twice the addresses of a window, so that it is never more than
+// half full.
+inline interval_stats::interval_stats(const std::size_t& window,
+                                      const double& threshold,
+                                      const std::size_t& capacity)
+    : window_(window ? std::min(window, max_window) : 1),
+      threshold_(threshold),
+      ring_(capacity ? capacity : 1),
+      head_(0),
+      count_(0),
+      current_{},
+      epoch_(1),
+      phase_rate_(0),
+      phase_windows_(0),
+      phases_(0) {
+  std::size_t table_size = 2;
+  while (table_size < 2 * window_) {
+    table_size *= 2;
+  }
+  seen_.assign(table_size, slot{0, 0});
+}
+
+// Returns the amount of windows kept.
+inline std::size_t interval_stats::size() const noexcept { return count_; }
+
+// Returns the i-th oldest window kept.
+inline const interval& interval_stats::operator[](const std::size_t& i) const
+    noexcept {
+  return ring_[(head_ + i) % ring_.size()];
+}
+
+// Returns the amount of phases detected.
+inline std::size_t interval_stats::phase_count() const noexcept {
+  return phases_;
+}
+
+// Outputs the windows kept as CSV.
+inline void interval_stats::write_csv(std::ostream& os) const {
+  os << "window,first_access,accesses,hits,misses,evictions,unique_blocks,"
+        "hit_rate,phase_change\n";
+  for (std::size_t i = 0; i < count_; ++i) {
+    const auto& w{(*this)[i]};
+    os << w.first / window_ << ',' << w.first << ',' << w.accesses << ','
+       << w.hits << ',' << w.misses << ',' << w.evictions << ',' << w.unique
+       << ',' << static_cast<double>(w.hits) / w.accesses << ','
+       << w.phase_change << '\n';
+  }
+}
+
+// Counts an allocation into the current window.
+inline void interval_stats::record(const std::int64_t& dir, const bool& hit,
+                                   const bool& evicted) {
+  current_.hits += hit;
+  current_.misses += !hit;
+  current_.evictions += evicted;
+  touch(dir);
+  if (++current_.accesses == window_) {
+    close_window();
+  }
+}
+
+// Closes the current window if it holds any allocation.
+inline void interval_stats::finish() {
+  if (current_.accesses) {
+    close_window();
+  }
+}
+
+// Counts the address as unique if it wasn't seen in the current window.
+// Slots of older epochs are free, so the table never needs to be cleared.
+inline void interval_stats::touch(const std::int64_t& dir) {
+  auto mask{seen_.size() - 1};
+  auto i{static_cast<std::size_t>(static_cast<std::uint64_t>(dir) *
+                                  0x9e3779b97f4a7c15 >> 32) &
+         mask};
+
+  while (seen_[i].epoch == epoch_) {
+    if (seen_[i].dir == dir) {
+      return;
+    }
+    i = (i + 1) & mask;
+  }
+  seen_[i] = {dir, epoch_};
+  ++current_.unique;
+}
+
+// Stores the current window in the ring, checking whether it starts a new
+// phase, and starts the next window.
+inline void interval_stats::close_window() {
+  auto rate{static_cast<double>(current_.hits) / current_.accesses};
+
+  if (!phase_windows_ ||
+      (threshold_ > 0 && std::fabs(rate - phase_rate_) > threshold_)) {
+    current_.phase_change = true;
+    phase_rate_ = rate;
+    phase_windows_ = 1;
+    ++phases_;
+  } else {
+    ++phase_windows_;
+    phase_rate_ += (rate - phase_rate_) / static_cast<double>(phase_windows_);
+  }
+
+  if (count_ < ring_.size()) {
+    ring_[(head_ + count_++) % ring_.size()] = current_;
+  } else {
+    ring_[head_] = current_;
+    head_ = (head_ + 1) % ring_.size();
+  }
+
+  auto next{current_.first + current_.accesses};
+  current_ = interval{};
+  current_.first = next;
+  if (++epoch_ == 0) {  // epochs wrapped, old slots would look current
+    seen_.assign(seen_.size(), slot{0, 0});
+    epoch_ = 1;
+  }
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_INTERVAL_STATS_H_
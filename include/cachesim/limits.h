@@ -14,6 +14,7 @@ constexpr const std::size_t it_max = 100;
 // architecture).
 constexpr const std::size_t num_min = 0;
 constexpr const std::size_t num_max = 65535;
+constexpr const unsigned address_bits = 16;
 
 // Power n values limits (2^n).
 constexpr const std::size_t pow_min = 0;
@@ -18,17 +18,46 @@ constexpr const std::string_view config_prefix = "-c=";
 constexpr const std::string_view data_prefix = "-d=";
 constexpr const std::string_view out_prefix = "-o=";
 constexpr const std::string_view hex_prefix = "-x";
+constexpr const std::string_view log_prefix = "-l=";
+constexpr const std::string_view binary_prefix = "-b";
+constexpr const std::string_view table_prefix = "-t=";
+constexpr const std::string_view format_prefix = "-f=";
+constexpr const std::string_view window_prefix = "-w=";
+constexpr const std::string_view stats_prefix = "-s=";
+constexpr const std::string_view phase_prefix = "-p=";
+constexpr const std::string_view conflict_prefix = "-a=";
+constexpr const std::string_view weight_prefix = "-r=";
+constexpr const std::string_view mask_prefix = "-m=";
+constexpr const std::string_view interleave_prefix = "-i=";
+constexpr const std::string_view tlb_prefix = "-T=";
+constexpr const std::string_view victim_prefix = "-V=";
+constexpr const std::string_view miss_cache_prefix = "-M=";
+
+// Interleave modes of several data files.
+constexpr const std::string_view interleave_weights = "weights";
+constexpr const std::string_view interleave_timestamps = "timestamps";
+
+// Server prefix, optionally followed by "=" and the socket path.
+constexpr const std::string_view serve_prefix = "--serve";
+constexpr const std::string_view serve_default_path = "/tmp/cachesim.sock";
 
 // Returns whether the given value is a version prefix.
-bool is_version_prefix(std::string_view s) {
+inline bool is_version_prefix(std::string_view s) {
   return s == version_prefix_s || s == version_prefix_l;
 }
 
 // Returns whether the given value is a help prefix.
-bool is_help_prefix(std::string_view s) {
+inline bool is_help_prefix(std::string_view s) {
   return s == help_prefix_s || s == help_prefix_l;
 }
 
+// Returns whether the given value is a server prefix.
+inline bool is_serve_prefix(std::string_view s) {
+  return s == serve_prefix ||
+         (s.rfind(serve_prefix, 0) == 0 && s.size() > serve_prefix.size() + 1 &&
+          s[serve_prefix.size()] == '=');
+}
+
 }  // namespace cachesim
 
 #endif  // CACHESIM_PREFIX_H_
@@ -0,0 +1,627 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_SERVER_H_
+#define CACHESIM_SERVER_H_
+
+#include <cachesim/cache.h>
+#include <cachesim/trace_reader.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace cachesim {
+namespace protocol {
+
+// Every message, in both directions, is a frame:
+//   uint32 length   bytes that follow the length field
+//   uint8  code     opcode (requests) or status (responses)
+//   ...    payload  length - 1 bytes
+// Integers use the host byte order, since clients are always local. Strings
+// are an uint16 length followed by the characters.
+
+// enum opcode
+// Defines the requests accepted by the server. The request payloads are:
+//   CREATE    name, uint32 size, uint32 type, uint32 line size, uint32 policy
+//             and optionally uint32 index policy
+//   LOAD      name, path of a data file read into memory, and optionally
+//             uint32 trace format and uint32 line size (TEXT and 1 if missing)
+//   ALLOCATE  cache name, uint32 n, n int64 addresses
+//   RUN       cache name, trace name
+//   COUNTERS  cache name
+//   CLEAR     cache name
+//   DROP      cache name
+//   SHUTDOWN  (empty)
+// ALLOCATE answers one byte per address (1 hit, 0 miss), RUN and COUNTERS
+// answer the uint64 hit and miss counts, the rest answer an empty payload.
+enum opcode : std::uint8_t {
+  CREATE = 1,
+  LOAD,
+  ALLOCATE,
+  RUN,
+  COUNTERS,
+  CLEAR,
+  DROP,
+  SHUTDOWN
+};
+
+// enum status
+// Defines the status codes of the responses.
+enum status : std::uint8_t {
+  OK = 0,
+  BAD_REQUEST,
+  UNKNOWN_OPCODE,
+  NO_SUCH_CACHE,
+  NO_SUCH_TRACE,
+  INVALID_CACHE,
+  FAILED_TO_OPEN
+};
+
+// Largest frame accepted by the server, in bytes.
+constexpr const std::uint32_t max_frame_size = 1 << 26;
+
+// Longest wait for the rest of a started frame, or for a client to take a
+// reply, in milliseconds. Slower clients are disconnected.
+constexpr const int frame_timeout_ms = 2000;
+
+// class payload_reader
+// Reads the fields of a request payload, keeping track of malformed ones.
+class payload_reader {
+ public:
+  // ctor
+  explicit payload_reader(const std::vector<char>& payload);
+  // accessors
+  bool good() const noexcept;
+  std::size_t remaining() const noexcept;
+  // mutators
+  template <typename T>
+  T read();
+  std::string read_string();
+
+ private:
+  // member variables
+  const std::vector<char>& payload_;  // payload being read
+  std::size_t pos_;                   // read position
+  bool good_;                         // no field was out of bounds
+};
+
+// Explicit ctor
+inline payload_reader::payload_reader(const std::vector<char>& payload)
+    : payload_(payload), pos_(0), good_(true) {}
+
+// Returns whether every field read so far was inside the payload.
+inline bool payload_reader::good() const noexcept { return good_; }
+
+// Returns the amount of bytes left to read.
+inline std::size_t payload_reader::remaining() const noexcept {
+  return payload_.size() - pos_;
+}
+
+// Returns the next integer of the payload, or 0 if the payload is too short.
+template <typename T>
+T payload_reader::read() {
+  T value{};
+
+  if (remaining() < sizeof(T)) {
+    good_ = false;
+    return value;
+  }
+  std::memcpy(&value, payload_.data() + pos_, sizeof(T));
+  pos_ += sizeof(T);
+  return value;
+}
+
+// Returns the next string of the payload, or an empty string if the payload is
+// too short.
+inline std::string payload_reader::read_string() {
+  auto n{read<std::uint16_t>()};
+
+  if (remaining() < n) {
+    good_ = false;
+    return std::string();
+  }
+  std::string s(payload_.data() + pos_, n);
+  pos_ += n;
+  return s;
+}
+
+}  // namespace protocol
+
+// class server
+// Keeps named caches and preloaded traces in memory and simulates the
+// allocations requested by local clients through a Unix domain socket.
+// Traces are parsed by trace_reader, in the formats of the command line and
+// with its checks, and kept as line addresses.
+// The accepting thread polls every idle client and hands the ones with a
+// pending request to a fixed pool of workers. A worker answers one request
+// and gives the client back, so any number of clients can share the pool.
+// A client which stops in the middle of a frame is disconnected after
+// protocol::frame_timeout_ms, and stopping the server interrupts the frames
+// being read, so no client can hold a worker.
+// Every cache is locked while a request is using it.
+class server {
+ public:
+  // ctor
+  explicit server(const std::string& path, const std::size_t& threads);
+  server(const server&) = delete;
+  server& operator=(const server&) = delete;
+  // dtor
+  ~server();
+  // mutators
+  bool run();
+
+ private:
+  // struct instance
+  // A named cache and the lock serializing its requests.
+  struct instance {
+    std::mutex mutex;
+    std::unique_ptr<cache> simulator;
+  };
+  using trace = std::vector<address>;
+  void work();
+  bool serve(const int& fd);
+  void give_back(const int& fd, const bool& keep);
+  protocol::status handle(const std::uint8_t& code,
+                          const std::vector<char>& payload,
+                          std::vector<char>* reply);
+  std::shared_ptr<instance> find_cache(const std::string& name);
+  std::shared_ptr<const trace> find_trace(const std::string& name);
+  void stop();
+  // member variables
+  std::string path_;                       // socket path
+  std::size_t threads_;                    // pool size
+  int listen_fd_;                          // listening socket
+  int wake_fds_[2];                        // pipe waking the accepting thread
+  bool stopping_;                          // shutdown requested
+  std::queue<int> pending_;                // clients with a pending request
+  std::vector<int> returned_;              // clients given back by workers
+  std::set<int> serving_;                  // clients being answered
+  std::mutex clients_mutex_;               // guards the client queues
+  std::condition_variable clients_ready_;  // signals pending_ and stopping_
+  std::vector<std::thread> pool_;          // worker threads
+  std::map<std::string, std::shared_ptr<instance>> caches_;     // named caches
+  std::map<std::string, std::shared_ptr<const trace>> traces_;  // traces
+  std::mutex caches_mutex_;                // guards caches_
+  std::mutex traces_mutex_;                // guards traces_
+};
+
+// Explicit ctor
+// The socket is not opened until the server runs.
+inline server::server(const std::string& path, const std::size_t& threads)
+    : path_(path),
+      threads_(threads ? threads : 1),
+      listen_fd_(-1),
+      wake_fds_{-1, -1},
+      stopping_(false) {}
+
+// Dtor
+// Stops the workers and removes the socket file.
+inline server::~server() { stop(); }
+
+#ifdef _WIN32
+// Unix domain sockets are not available, the server can't run.
+inline bool server::run() { return false; }
+inline void server::work() {}
+inline bool server::serve(const int&) { return false; }
+inline void server::give_back(const int&, const bool&) {}
+inline void server::stop() {}
+#else
+// Reads exactly n bytes from the socket.
+// Returns false if the connection was closed or failed before.
+inline bool read_all(const int& fd, void* buf, std::size_t n) {
+  auto p{static_cast<char*>(buf)};
+
+  while (n) {
+    auto got{::read(fd, p, n)};
+    if (got <= 0) {
+      return false;
+    }
+    p += got;
+    n -= static_cast<std::size_t>(got);
+  }
+  return true;
+}
+
+// Writes exactly n bytes to the socket.
+// Returns false if the connection was closed or failed before.
+inline bool write_all(const int& fd, const void* buf, std::size_t n) {
+  auto p{static_cast<const char*>(buf)};
+
+  while (n) {
+    auto sent{::write(fd, p, n)};
+    if (sent <= 0) {
+      return false;
+    }
+    p += sent;
+    n -= static_cast<std::size_t>(sent);
+  }
+  return true;
+}
+
+// Binds the socket, starts the worker pool and dispatches client requests
+// until a SHUTDOWN request arrives.
+// The socket is only accessible by the user running the server.
+// Returns false if the socket couldn't be opened, or if another server is
+// listening on it.
+inline bool server::run() {
+  sockaddr_un addr{};
+  struct stat st {};
+  std::vector<pollfd> watched;
+
+  if (path_.size() >= sizeof(addr.sun_path) || ::pipe(wake_fds_)) {
+    return false;
+  }
+  listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    return false;
+  }
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+  // A socket left behind by an earlier server is replaced, a socket with a
+  // server listening and any other file are left alone.
+  if (::stat(path_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+    auto probe{::socket(AF_UNIX, SOCK_STREAM, 0)};
+    auto listening{probe >= 0 &&
+                   !::connect(probe, reinterpret_cast<sockaddr*>(&addr),
+                              sizeof(addr))};
+    if (probe >= 0) {
+      ::close(probe);
+    }
+    if (listening) {
+      ::close(listen_fd_);
+      listen_fd_ = -1;
+      return false;
+    }
+    ::unlink(path_.c_str());
+  }
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) ||
+      ::chmod(path_.c_str(), S_IRUSR | S_IWUSR) ||
+      ::listen(listen_fd_, SOMAXCONN)) {
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  ::signal(SIGPIPE, SIG_IGN);
+  for (std::size_t i = 0; i < threads_; ++i) {
+    pool_.emplace_back(&server::work, this);
+  }
+
+  // The first two entries are always the listening socket and the wake pipe,
+  // the rest are the idle clients.
+  watched.push_back({listen_fd_, POLLIN, 0});
+  watched.push_back({wake_fds_[0], POLLIN, 0});
+  for (;;) {
+    if (::poll(watched.data(), watched.size(), -1) < 0) {
+      continue;
+    }
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    if (stopping_) {
+      for (std::size_t i = 2; i < watched.size(); ++i) {
+        ::close(watched[i].fd);
+      }
+      break;
+    }
+    if (watched[1].revents) {
+      char drain[64];
+      (void)::read(wake_fds_[0], drain, sizeof(drain));
+    }
+    for (std::size_t i = 2; i < watched.size();) {
+      if (watched[i].revents) {  // request or hang up, a worker will tell
+        pending_.push(watched[i].fd);
+        clients_ready_.notify_one();
+        watched[i] = watched.back();
+        watched.pop_back();
+      } else {
+        ++i;
+      }
+    }
+    if (watched[0].revents) {
+      auto fd{::accept(listen_fd_, nullptr, nullptr)};
+      if (fd >= 0) {
+        timeval timeout{protocol::frame_timeout_ms / 1000,
+                        protocol::frame_timeout_ms % 1000 * 1000};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        watched.push_back({fd, POLLIN, 0});
+      }
+    }
+    for (const auto& fd : returned_) {
+      watched.push_back({fd, POLLIN, 0});
+    }
+    returned_.clear();
+  }
+
+  stop();
+  return true;
+}
+
+// Worker thread loop.
+// Answers a request of each client taken from the queue, giving the client
+// back to the accepting thread unless it disconnected or timed out.
+inline void server::work() {
+  for (;;) {
+    int fd = -1;
+    {
+      std::unique_lock<std::mutex> lock(clients_mutex_);
+      clients_ready_.wait(lock,
+                          [this] { return stopping_ || !pending_.empty(); });
+      if (stopping_) {
+        return;
+      }
+      fd = pending_.front();
+      pending_.pop();
+      serving_.insert(fd);
+    }
+    give_back(fd, serve(fd));
+  }
+}
+
+// Reads a request frame from a client and answers it.
+// Returns false if the client disconnected or sent a malformed frame.
+inline bool server::serve(const int& fd) {
+  std::vector<char> payload;
+  std::vector<char> reply;
+  std::uint32_t length = 0;
+  std::uint8_t code = 0;
+
+  if (!read_all(fd, &length, sizeof(length)) || !length ||
+      length > protocol::max_frame_size ||
+      !read_all(fd, &code, sizeof(code))) {
+    return false;
+  }
+  payload.resize(length - 1);
+  if (!read_all(fd, payload.data(), payload.size())) {
+    return false;
+  }
+
+  std::uint8_t result = handle(code, payload, &reply);
+  std::uint32_t reply_length = static_cast<std::uint32_t>(reply.size() + 1);
+  if (!write_all(fd, &reply_length, sizeof(reply_length)) ||
+      !write_all(fd, &result, sizeof(result)) ||
+      !write_all(fd, reply.data(), reply.size())) {
+    return false;
+  }
+  if (code == protocol::SHUTDOWN) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    stopping_ = true;
+    clients_ready_.notify_all();
+  }
+  return true;
+}
+
+// Returns a client to the accepting thread, waking it up so that it polls
+// the client again. Clients not kept, or given back while stopping, are
+// closed.
+inline void server::give_back(const int& fd, const bool& keep) {
+  std::lock_guard<std::mutex> lock(clients_mutex_);
+  char wake = 0;
+
+  serving_.erase(fd);
+  if (stopping_ || !keep) {
+    ::close(fd);
+  } else {
+    returned_.push_back(fd);
+  }
+  (void)::write(wake_fds_[1], &wake, sizeof(wake));
+}
+
+// Stops dispatching requests, interrupts the frames the workers are reading,
+// waits for the workers to finish, closes every client and removes the socket
+// file.
+inline void server::stop() {
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    stopping_ = true;
+    for (const auto& fd : serving_) {
+      ::shutdown(fd, SHUT_RDWR);
+    }
+  }
+  clients_ready_.notify_all();
+  for (auto& worker : pool_) {
+    worker.join();
+  }
+  pool_.clear();
+  for (; !pending_.empty(); pending_.pop()) {
+    ::close(pending_.front());
+  }
+  for (const auto& fd : returned_) {
+    ::close(fd);
+  }
+  returned_.clear();
+  for (auto& fd : wake_fds_) {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  if (listen_fd_ >= 0) {
+    ::close(listen_fd_);
+    ::unlink(path_.c_str());
+    listen_fd_ = -1;
+  }
+}
+#endif  // _WIN32
+
+// Answers a single request, appending the response payload to reply.
+inline protocol::status server::handle(const std::uint8_t& code,
+                                       const std::vector<char>& payload,
+                                       std::vector<char>* reply) {
+  protocol::payload_reader in(payload);
+  auto append_counters = [reply](const cache& c) {
+    std::uint64_t counters[2] = {c.hit_count(), c.miss_count()};
+    auto p{reinterpret_cast<const char*>(counters)};
+    reply->insert(reply->end(), p, p + sizeof(counters));
+  };
+
+  switch (code) {
+    case protocol::CREATE: {
+      auto name{in.read_string()};
+      auto size{in.read<std::uint32_t>()};
+      auto type{in.read<std::uint32_t>()};
+      auto line_size{in.read<std::uint32_t>()};
+      auto policy{in.read<std::uint32_t>()};
+      auto index{in.remaining() ? in.read<std::uint32_t>()
+                                : std::uint32_t{MODULO}};
+      if (!in.good() || name.empty()) {
+        return protocol::BAD_REQUEST;
+      }
+      if (policy > MRU || index > PRIME_MODULO ||
+          !is_valid_size(size, line_size)) {
+        return protocol::INVALID_CACHE;
+      }
+      auto created{std::make_shared<instance>()};
+      try {
+        created->simulator =
+            make_cache(size, static_cast<int>(type), line_size,
+                       static_cast<int>(policy),
+                       static_cast<index_policy>(index),
+                       std::cout, false);
+      } catch (const std::exception& e) {
+        created->simulator = nullptr;
+      }
+      if (!created->simulator) {
+        return protocol::INVALID_CACHE;
+      }
+      created->simulator->set_quiet(true);
+      std::lock_guard<std::mutex> lock(caches_mutex_);
+      caches_[name] = created;
+      return protocol::OK;
+    }
+    case protocol::LOAD: {
+      auto name{in.read_string()};
+      auto path{in.read_string()};
+      auto format{in.remaining() ? in.read<std::uint32_t>()
+                                 : std::uint32_t{TEXT}};
+      auto line_size{in.remaining() ? in.read<std::uint32_t>()
+                                    : std::uint32_t{1}};
+      if (!in.good() || name.empty() || format > DRMEMTRACE ||
+          !is_valid_size(line_size, line_size)) {
+        return protocol::BAD_REQUEST;
+      }
+      std::ifstream is(path, std::ios::in | std::ios::binary);
+      if (!is.is_open()) {
+        return protocol::FAILED_TO_OPEN;
+      }
+      auto loaded{std::make_shared<trace>()};
+      trace_reader reader(is, static_cast<trace_format>(format), line_size);
+      reader.read([&](const address& dir) { loaded->push_back(dir); });
+      std::lock_guard<std::mutex> lock(traces_mutex_);
+      traces_[name] = loaded;
+      return protocol::OK;
+    }
+    case protocol::ALLOCATE: {
+      auto name{in.read_string()};
+      auto n{in.read<std::uint32_t>()};
+      if (!in.good() || in.remaining() != n * sizeof(std::int64_t)) {
+        return protocol::BAD_REQUEST;
+      }
+      std::vector<address> addresses(n);
+      for (auto& value : addresses) {
+        value = in.read<address>();
+        if (value < 0) {
+          return protocol::BAD_REQUEST;
+        }
+      }
+      auto target{find_cache(name)};
+      if (!target) {
+        return protocol::NO_SUCH_CACHE;
+      }
+      reply->resize(n);
+      std::lock_guard<std::mutex> lock(target->mutex);
+      for (std::uint32_t i = 0; i < n; ++i) {
+        (*reply)[i] = target->simulator->allocate(addresses[i]);
+      }
+      return protocol::OK;
+    }
+    case protocol::RUN: {
+      auto name{in.read_string()};
+      auto trace_name{in.read_string()};
+      if (!in.good()) {
+        return protocol::BAD_REQUEST;
+      }
+      auto target{find_cache(name)};
+      if (!target) {
+        return protocol::NO_SUCH_CACHE;
+      }
+      auto source{find_trace(trace_name)};
+      if (!source) {
+        return protocol::NO_SUCH_TRACE;
+      }
+      std::lock_guard<std::mutex> lock(target->mutex);
+      for (const auto& dir : *source) {
+        target->simulator->allocate(dir);
+      }
+      append_counters(*target->simulator);
+      return protocol::OK;
+    }
+    case protocol::COUNTERS:
+    case protocol::CLEAR: {
+      auto target{find_cache(in.read_string())};
+      if (!in.good()) {
+        return protocol::BAD_REQUEST;
+      }
+      if (!target) {
+        return protocol::NO_SUCH_CACHE;
+      }
+      std::lock_guard<std::mutex> lock(target->mutex);
+      if (code == protocol::COUNTERS) {
+        append_counters(*target->simulator);
+      } else {  // resizing to the same sizes wipes the items and counters
+        target->simulator->resize(target->simulator->size(),
+                                  target->simulator->line_size());
+      }
+      return protocol::OK;
+    }
+    case protocol::DROP: {
+      auto name{in.read_string()};
+      if (!in.good()) {
+        return protocol::BAD_REQUEST;
+      }
+      std::lock_guard<std::mutex> lock(caches_mutex_);
+      return caches_.erase(name) ? protocol::OK : protocol::NO_SUCH_CACHE;
+    }
+    case protocol::SHUTDOWN:
+      return protocol::OK;
+    default:
+      return protocol::UNKNOWN_OPCODE;
+  }
+}
+
+// Returns the named cache, or nullptr if there is no such cache.
+inline std::shared_ptr<server::instance> server::find_cache(
+    const std::string& name) {
+  std::lock_guard<std::mutex> lock(caches_mutex_);
+  auto it{caches_.find(name)};
+  return it == caches_.end() ? nullptr : it->second;
+}
+
+// Returns the named trace, or nullptr if there is no such trace.
+inline std::shared_ptr<const server::trace> server::find_trace(
+    const std::string& name) {
+  std::lock_guard<std::mutex> lock(traces_mutex_);
+  auto it{traces_.find(name)};
+  return it == traces_.end() ? nullptr : it->second;
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_SERVER_H_
@@ -3,13 +3,33 @@
 #define CACHESIM_SET_ASSOCIATIVE_CACHE_H_
 
 #include <cachesim/cache_.h>
+#include <cachesim/set_index.h>
+#include <cachesim/tag_array.h>
 
 #include <cmath>
 
 namespace cachesim {
 
+// Returns the appropiate set count for a set-associative cache of the given
+// amount of items.
+// This tries to make the cache set count as close as possible to the max amount
+// of items inside a set. This means that it tries to aproximate to an n*n
+// matrix but having the set count lower than the set item count.
+inline std::size_t associative_set_count(
+    const std::size_t& items_count) noexcept {
+  auto items_count_log2{static_cast<std::size_t>(log2(items_count))};
+
+  return items_count > 2
+             ? !(items_count_log2 % 2) ? items_count_log2 : items_count_log2 - 1
+             : 1;
+}
+
 // class set_associative_cache
 // Represents a set-associative mapped cache.
+// Every set is a fixed run of ways inside one flat array. The first ways of a
+// set hold its items ordered from least to most recently used, the remaining
+// ones are empty. Ways only keep the tag of their address, sized for the
+// address bits of the cache.
 // Inherits from cache.
 class set_associative_cache final : public cache {
  public:
@@ -18,7 +38,7 @@ class set_associative_cache final : public cache {
   explicit set_associative_cache(const std::size_t& size,
                                  const std::size_t& line_size,
                                  const int& policy, std::ostream& os,
-                                 const bool& hex);
+                                 const bool& hex, const int& index = MODULO);
   ~set_associative_cache() = default;
   // accessors
   virtual std::size_t set_count() const noexcept;
@@ -26,108 +46,120 @@ class set_associative_cache final : public cache {
   void clear() override final;
   void resize(const std::size_t& size,
               const std::size_t& line_size) override final;
-  void allocate(const int& value) override final;
+  bool allocate(const address& value) override final;
 
  private:
   std::size_t get_set_count() const noexcept;
-  int get_id(const int& value) const noexcept override final;
-  void replace(const int& id, const int& value);
-  void replace_lru(const int& id, const int& value) noexcept;
-  void replace_mru(const int& id, const int& value) noexcept;
+  int get_id(const address& value) const noexcept override final;
+  address line(const int& id, const std::size_t& way) const noexcept;
+  void replace(const int& id, const std::uint64_t& tag);
+  void replace_lru(const int& id, const std::uint64_t& tag);
+  void replace_mru(const int& id, const std::uint64_t& tag);
   // member variables
-  std::size_t set_count_;         // number of cache sets
-  std::vector<cache_set> items_;  // cache sets of items
+  std::size_t set_count_;  // number of cache sets
+  std::size_t ways_;       // number of items in a set
+  set_index index_;        // address to set mapping
+  tag_array tags_;         // tags of the cache sets, one after another
 };
 
 // Default ctor
 // Creates a 1 set cache.
-set_associative_cache::set_associative_cache()
-    : cache(), set_count_(1), items_(1, cache_set()) {}
+inline set_associative_cache::set_associative_cache()
+    : cache(), set_count_(1), ways_(1), index_(), tags_() {}
 
 // Explicit ctor
-// Creates an n sets cache.
+// Creates an n sets cache, mapping addresses to sets with the given index
+// policy.
 // The sizes check is performed under the cache ctor.
-set_associative_cache::set_associative_cache(const std::size_t& size,
-                                             const std::size_t& line_size,
-                                             const int& policy,
-                                             std::ostream& os, const bool& hex)
+inline set_associative_cache::set_associative_cache(
+    const std::size_t& size, const std::size_t& line_size, const int& policy,
+    std::ostream& os, const bool& hex, const int& index)
     : cache(size, line_size, policy, os, hex),
       set_count_(get_set_count()),
-      items_(set_count_, cache_set()) {}
+      ways_(items_count_ / set_count_),
+      index_(static_cast<index_policy>(index), set_count_),
+      tags_(set_count_ * ways_, index_.tag_bits(address_bits_)) {}
 
 // Returns the set count of the cache.
-std::size_t set_associative_cache::set_count() const noexcept {
+inline std::size_t set_associative_cache::set_count() const noexcept {
   return set_count_;
 }
 
 // Wipes all sets.
-void set_associative_cache::clear() {
-  std::for_each(items_.begin(), items_.end(), [](auto set) { set.clear(); });
+inline void set_associative_cache::clear() {
+  tags_.clear();
   hit_count_ = 0;
   miss_count_ = 0;
 }
 
 // Resizes the cache and the sets after checking the sizes.
-void set_associative_cache::resize(const std::size_t& size,
-                                   const std::size_t& line_size) {
+inline void set_associative_cache::resize(const std::size_t& size,
+                                          const std::size_t& line_size) {
   set_size(size, line_size);
   set_count_ = get_set_count();
-  items_.clear();
-  items_.resize(set_count_, cache_set());
+  ways_ = items_count_ / set_count_;
+  index_ = set_index(index_.policy(), set_count_);
+  tags_ = tag_array(set_count_ * ways_, index_.tag_bits(address_bits_));
 }
 
 // Puts an element in its belonged set inside cache.
-// Also prints the current allocation attempt.
+// Also prints the current allocation attempt and returns whether it was a hit.
+// The set is searched for its first empty way in the validity bitmap, then
+// for the tag among the ways before it with the vectorized tag kernels.
 // This is the main interaction function.
-void set_associative_cache::allocate(const int& value) {
+inline bool set_associative_cache::allocate(const address& value) {
   auto id{get_id(value)};
-  auto set_size{items_count_ / set_count_};
-  auto set_it{std::find(items_[id].begin(), items_[id].end(), value)};
-  auto found{set_it != std::end(items_[id])};
-
-  print_line(value, found, id,
-             (items_[id].size() < set_size ? empty_space : items_[id].back()));
+  auto first{id * ways_};
+  auto tag{index_.tag(value)};
+  auto fill{tags_.find_empty(first, ways_)};
+  auto way{tags_.find(first, fill, tag)};
+  auto found{way != fill};
+
+  record(value, found, id, (fill < ways_ ? empty_space : line(id, fill - 1)),
+         (found || fill < ways_ ? empty_space
+                                : line(id, policy_ == LRU ? 0 : ways_ - 1)));
   if (found) {
-    items_[id].erase(set_it);
-    items_[id].push_back(value);
+    tags_.rotate(first + way, first + way + 1, first + fill);
     ++hit_count_;
   } else {
-    if (items_[id].size() < set_size) {  // set has space
-      items_[id].push_back(value);
+    if (fill < ways_) {  // set has space
+      tags_.set(first + fill, tag);
     } else {  // set is full
-      replace(id, value);
+      replace(id, tag);
     }
     ++miss_count_;
   }
+
+  return found;
 }
 
 // Returns the appropiate set count based on the max amount of items in cache.
-// This tries to make the cache set count as close as possible to the max amount
-// of items inside a set. This means that it tries to aproximate to an n*n
-// matrix but having the set count lower than the set item count.
-std::size_t set_associative_cache::get_set_count() const noexcept {
-  auto items_count_log2{static_cast<std::size_t>(log2(items_count_))};
-
-  return items_count_ > 2
-             ? !(items_count_log2 % 2) ? items_count_log2 : items_count_log2 - 1
-             : 1;
+inline std::size_t set_associative_cache::get_set_count() const noexcept {
+  return associative_set_count(items_count_);
 }
 
 // Returns the id of the set in which the new ellement should be allocated.
-int set_associative_cache::get_id(const int& value) const noexcept {
-  return value % set_count_;
+inline int set_associative_cache::get_id(const address& value) const noexcept {
+  return index_(value);
+}
+
+// Returns the address held in a way of a set.
+inline address set_associative_cache::line(
+    const int& id, const std::size_t& way) const noexcept {
+  return static_cast<address>(index_.rebuild(tags_[id * ways_ + way], id));
 }
 
 // Calls the appropiate replace algorithm depending on the initial
 // configuration. In case the policy is not in range, it will throw an
 // exception.
-void set_associative_cache::replace(const int& id, const int& value) {
+inline void set_associative_cache::replace(const int& id,
+                                           const std::uint64_t& tag) {
   switch (policy_) {
     case LRU:
-      replace_lru(id, value);
+      replace_lru(id, tag);
       break;
     case MRU:
-      replace_mru(id, value);
+      replace_mru(id, tag);
       break;
     default:
       throw std::invalid_argument("No such replacement policy");
@@ -136,16 +168,18 @@ void set_associative_cache::replace(const int& id, const int& value) {
 }
 
 // Replaces the least recently used value with the new value to be allocated.
-void set_associative_cache::replace_lru(const int& id,
-                                        const int& value) noexcept {
-  items_[id].erase(items_[id].begin());
-  items_[id].push_back(value);
+inline void set_associative_cache::replace_lru(const int& id,
+                                               const std::uint64_t& tag) {
+  auto first{id * ways_};
+
+  tags_.rotate(first, first + 1, first + ways_);
+  tags_.set(first + ways_ - 1, tag);
 }
 
 // Replaces the most recently used value with the new value to be allocated.
-void set_associative_cache::replace_mru(const int& id,
-                                        const int& value) noexcept {
-  *std::prev(items_[id].end()) = value;
+inline void set_associative_cache::replace_mru(const int& id,
+                                               const std::uint64_t& tag) {
+  tags_.set(id * ways_ + ways_ - 1, tag);
 }
 
 }  // namespace cachesim
@@ -0,0 +1,192 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_SET_INDEX_H_
+#define CACHESIM_SET_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cachesim {
+
+// enum index_policy
+// Defines the function mapping an address to a set, as numbered in the
+// config file.
+enum index_policy { MODULO, XOR_FOLD, PRIME_MODULO };
+
+// Odd multipliers scrambling the folded bits, one per skew.
+// The first one leaves the bits untouched.
+constexpr const std::uint64_t skew_multipliers[] = {
+    1, 0x9e3779b97f4a7c15, 0xc2b2ae3d27d4eb4f, 0x165667b19e3779f9,
+    0xd6e8feb86659fd93, 0xff51afd7ed558ccd, 0xc4ceb9fe1a85ec53,
+    0x94d049bb133111eb};
+
+constexpr const std::size_t skew_count =
+    sizeof(skew_multipliers) / sizeof(skew_multipliers[0]);
+
+// class set_index
+// Maps addresses to one of count sets.
+// The mapping function is chosen once in the ctor and selected by a switch
+// that is inlined into the caller, so mapping an address needs no indirect
+// call. Power of 2 set counts map with masks and shifts only.
+//   MODULO        address % count.
+//   XOR_FOLD      the low part of the address (address % count) combined with
+//                 the folded high part (address / count), XOR-ed when count is
+//                 a power of 2 and added modulo count otherwise. The skew
+//                 scrambles the high part first, giving a different function
+//                 for every skew.
+//   PRIME_MODULO  address % p, where p is the largest prime not greater than
+//                 count. Sets from p up to count are never used.
+// Every function splits an address into its set and a tag (address / count,
+// or address / p), and the address can be rebuilt from both, so caches only
+// need to store the tags.
+class set_index {
+ public:
+  // ctor
+  set_index();
+  explicit set_index(const index_policy& policy, const std::size_t& count,
+                     const std::size_t& skew = 0);
+  // accessors
+  index_policy policy() const noexcept;
+  std::size_t count() const noexcept;
+  std::size_t operator()(const std::uint64_t& value) const noexcept;
+  std::uint64_t tag(const std::uint64_t& value) const noexcept;
+  std::uint64_t rebuild(const std::uint64_t& tag,
+                        const std::size_t& set) const noexcept;
+  unsigned tag_bits(const unsigned& address_bits) const noexcept;
+
+ private:
+  // enum mapping
+  // Defines the mapping function chosen for the policy and the set count.
+  enum mapping { DIVISION, FOLDING, FOLDING_POW2 };
+  static std::uint64_t largest_prime(const std::uint64_t& n) noexcept;
+  std::uint64_t fold(const std::uint64_t& high) const noexcept;
+  // member variables
+  index_policy policy_;     // mapping policy
+  std::size_t count_;       // number of sets
+  std::uint64_t divisor_;   // divisor of the address
+  std::uint64_t mask_;      // mask of the folded bits
+  unsigned bits_;           // width of the folded bits
+  unsigned shift_;          // log2 of the divisor, 64 if not a power of 2
+  std::uint64_t scramble_;  // multiplier of the high part
+  mapping mapping_;         // mapping function
+};
+
+// Default ctor
+// Maps every address to the only set.
+inline set_index::set_index() : set_index(MODULO, 1) {}
+
+// Explicit ctor
+// Unknown policies fall back to MODULO; make_cache rejects them before.
+inline set_index::set_index(const index_policy& policy,
+                            const std::size_t& count, const std::size_t& skew)
+    : policy_(policy),
+      count_(count ? count : 1),
+      divisor_(count_),
+      mask_(0),
+      bits_(0),
+      shift_(0),
+      scramble_(skew_multipliers[skew % skew_count]),
+      mapping_(DIVISION) {
+  while ((std::uint64_t{1} << (bits_ + 1)) <= count_ && bits_ < 63) {
+    ++bits_;
+  }
+  mask_ = (std::uint64_t{1} << bits_) - 1;
+
+  switch (policy_) {
+    case XOR_FOLD:
+      if (bits_) {
+        mapping_ = (count_ & (count_ - 1)) ? FOLDING : FOLDING_POW2;
+      }
+      break;
+    case PRIME_MODULO:
+      divisor_ = largest_prime(count_);
+      break;
+    default:
+      policy_ = MODULO;
+      break;
+  }
+  while ((std::uint64_t{1} << shift_) < divisor_ && shift_ < 63) {
+    ++shift_;
+  }
+  if ((std::uint64_t{1} << shift_) != divisor_) {
+    shift_ = 64;
+  }
+}
+
+// Returns the mapping policy.
+inline index_policy set_index::policy() const noexcept { return policy_; }
+
+// Returns the number of sets.
+inline std::size_t set_index::count() const noexcept { return count_; }
+
+// Returns the set of the given address.
+//   DIVISION      address % divisor (MODULO and PRIME_MODULO).
+//   FOLDING       XOR_FOLD for any set count.
+//   FOLDING_POW2  XOR_FOLD for power of 2 set counts.
+inline std::size_t set_index::operator()(const std::uint64_t& value) const
+    noexcept {
+  switch (mapping_) {
+    case FOLDING_POW2:
+      return (value & mask_) ^ fold(value >> bits_);
+    case FOLDING:
+      return (value % count_ + fold(value / count_)) % count_;
+    default:
+      return shift_ < 64 ? value & (divisor_ - 1) : value % divisor_;
+  }
+}
+
+// Returns the tag of the given address, the part not given by its set.
+inline std::uint64_t set_index::tag(const std::uint64_t& value) const noexcept {
+  return shift_ < 64 ? value >> shift_ : value / divisor_;
+}
+
+// Returns the address with the given tag mapped to the given set.
+inline std::uint64_t set_index::rebuild(const std::uint64_t& tag,
+                                        const std::size_t& set) const noexcept {
+  if (mapping_ == FOLDING_POW2) {
+    return tag << bits_ | (set ^ fold(tag));
+  }
+  if (mapping_ == FOLDING) {
+    return tag * count_ + (set + count_ - fold(tag)) % count_;
+  }
+  return tag * divisor_ + set;
+}
+
+// Returns the bits needed by the tags of addresses of the given width.
+inline unsigned set_index::tag_bits(const unsigned& address_bits) const
+    noexcept {
+  unsigned index_bits = 0;
+
+  while ((std::uint64_t{2} << index_bits) <= divisor_ && index_bits < 63) {
+    ++index_bits;
+  }
+  return address_bits > index_bits ? address_bits - index_bits : 1;
+}
+
+// Returns the largest prime not greater than n (n itself for n < 2).
+inline std::uint64_t set_index::largest_prime(const std::uint64_t& n) noexcept {
+  for (auto p{n}; p > 2; --p) {
+    auto prime{true};
+    for (std::uint64_t d = 2; d * d <= p && prime; ++d) {
+      prime = p % d;
+    }
+    if (prime) {
+      return p;
+    }
+  }
+  return n;
+}
+
+// Folds the scrambled high part of an address into bits_ bits by XOR-ing its
+// bits_ wide chunks.
+inline std::uint64_t set_index::fold(const std::uint64_t& high) const noexcept {
+  std::uint64_t folded = 0;
+
+  for (auto rest{high * scramble_}; rest; rest >>= bits_) {
+    folded ^= rest & mask_;
+  }
+  return folded;
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_SET_INDEX_H_
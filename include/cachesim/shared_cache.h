@@ -0,0 +1,299 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_SHARED_CACHE_H_
+#define CACHESIM_SHARED_CACHE_H_
+
+#include <cachesim/cache_.h>
+#include <cachesim/set_associative_cache.h>
+#include <cachesim/set_index.h>
+#include <cachesim/tag_array.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cachesim {
+
+// Max number of tenants sharing a cache.
+constexpr const std::size_t max_tenants = 256;
+
+// type way_mask
+// Defines the ways a tenant may fill, one bit per way starting by the lowest
+// bit of the first word.
+using way_mask = std::vector<std::uint64_t>;
+
+// struct tenant_counters
+// Counters of the allocations of a tenant of a shared cache.
+struct tenant_counters {
+  std::uint64_t hits;          // cache hits
+  std::uint64_t misses;        // cache misses
+  std::uint64_t evictions;     // lines replaced by the tenant's misses
+  std::uint64_t interference;  // lines of the tenant replaced by other tenants
+  std::uint64_t lines;         // lines currently owned by the tenant
+};
+
+// Sets the way mask written in hex in s (as in Intel CAT, "f0" allows ways 4
+// to 7). Returns false if s is not a hex number.
+inline bool parse_way_mask(std::string_view s, way_mask* mask) {
+  mask->clear();
+  if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+    s.remove_prefix(2);
+  }
+  if (s.empty()) {
+    return false;
+  }
+  while (!s.empty()) {
+    auto digits{std::min<std::size_t>(s.size(), 16)};
+    std::uint64_t word = 0;
+    auto last{s.data() + s.size()};
+    auto result{std::from_chars(last - digits, last, word, 16)};
+    if (result.ec != std::errc() || result.ptr != last) {
+      return false;
+    }
+    mask->push_back(word);
+    s.remove_suffix(digits);
+  }
+  return true;
+}
+
+// class shared_cache
+// Represents a set-associative cache shared by several tenants, with the same
+// sets and ways as a set_associative_cache of its size.
+// Every line keeps the tenant which filled it and the time of its last use, so
+// that the ways keep their place in the set. Every tenant hits in any way, but
+// fills only the ways allowed by its way mask, where the replaced line is
+// chosen with the emplace policy.
+// Inherits from cache.
+class shared_cache final : public cache {
+ public:
+  // ctor
+  explicit shared_cache(const std::size_t& size, const std::size_t& line_size,
+                        const int& policy, std::ostream& os, const bool& hex,
+                        const int& index, const std::size_t& tenants);
+  ~shared_cache() = default;
+  // accessors
+  std::size_t set_count() const noexcept;
+  std::size_t way_count() const noexcept;
+  std::size_t tenant_count() const noexcept;
+  const tenant_counters& counters(const std::size_t& tenant) const noexcept;
+  // mutators
+  bool set_way_mask(const std::size_t& tenant, const way_mask& mask);
+  void set_tenant(const std::size_t& tenant) noexcept;
+  void clear() override final;
+  void resize(const std::size_t& size,
+              const std::size_t& line_size) override final;
+  bool allocate(const address& value) override final;
+
+ private:
+  int get_id(const address& value) const noexcept override final;
+  void build_sets();
+  bool allowed(const std::size_t& way) const noexcept;
+  std::size_t find(const std::size_t& first,
+                   const std::uint64_t& tag) const noexcept;
+  std::size_t replace(const std::size_t& first) const noexcept;
+  // member variables
+  std::size_t set_count_;                 // number of cache sets
+  std::size_t ways_;                      // number of items in a set
+  set_index index_;                       // address to set mapping
+  tag_array tags_;                        // tags of the sets, one after another
+  std::vector<std::uint8_t> owners_;      // tenant of every line
+  std::vector<std::uint64_t> uses_;       // time of the last use of every line
+  std::uint64_t clock_;                   // current time
+  std::vector<way_mask> masks_;           // ways every tenant may fill
+  std::vector<tenant_counters> tenants_;  // counters of every tenant
+  std::size_t tenant_;                    // tenant of the next allocations
+};
+
+// Explicit ctor
+// Creates a cache shared by the given amount of tenants, up to max_tenants,
+// every one of them allowed to fill any way.
+// The sizes check is performed under the cache ctor.
+inline shared_cache::shared_cache(const std::size_t& size,
+                                  const std::size_t& line_size,
+                                  const int& policy, std::ostream& os,
+                                  const bool& hex, const int& index,
+                                  const std::size_t& tenants)
+    : cache(size, line_size, policy, os, hex),
+      index_(static_cast<index_policy>(index), 1),
+      clock_(0),
+      masks_(std::min(std::max<std::size_t>(tenants, 1), max_tenants)),
+      tenants_(masks_.size(), tenant_counters{}),
+      tenant_(0) {
+  build_sets();
+}
+
+// Returns the set count of the cache.
+inline std::size_t shared_cache::set_count() const noexcept {
+  return set_count_;
+}
+
+// Returns the number of ways of every set.
+inline std::size_t shared_cache::way_count() const noexcept { return ways_; }
+
+// Returns the number of tenants.
+inline std::size_t shared_cache::tenant_count() const noexcept {
+  return tenants_.size();
+}
+
+// Returns the counters of a tenant.
+inline const tenant_counters& shared_cache::counters(
+    const std::size_t& tenant) const noexcept {
+  return tenants_[tenant];
+}
+
+// Restricts the ways a tenant may fill. Bits over the number of ways are
+// ignored. Returns false, leaving the mask unchanged, if the mask allows no
+// way at all.
+inline bool shared_cache::set_way_mask(const std::size_t& tenant,
+                                       const way_mask& mask) {
+  way_mask used((ways_ + 63) / 64, 0);
+
+  for (std::size_t i = 0; i < used.size() && i < mask.size(); ++i) {
+    used[i] = mask[i];
+  }
+  if (ways_ % 64) {
+    used.back() &= (std::uint64_t{1} << (ways_ % 64)) - 1;
+  }
+  if (std::all_of(used.begin(), used.end(),
+                  [](const std::uint64_t& word) { return !word; })) {
+    return false;
+  }
+  masks_[tenant] = used;
+  return true;
+}
+
+// Sets the tenant of the following allocations.
+inline void shared_cache::set_tenant(const std::size_t& tenant) noexcept {
+  tenant_ = tenant;
+}
+
+// Wipes all sets and the counters of every tenant. Way masks are kept.
+inline void shared_cache::clear() {
+  tags_.clear();
+  std::fill(uses_.begin(), uses_.end(), 0);
+  std::fill(tenants_.begin(), tenants_.end(), tenant_counters{});
+  clock_ = 0;
+  hit_count_ = 0;
+  miss_count_ = 0;
+}
+
+// Resizes the cache and the sets after checking the sizes. Every tenant may
+// fill any way again.
+inline void shared_cache::resize(const std::size_t& size,
+                                 const std::size_t& line_size) {
+  set_size(size, line_size);
+  build_sets();
+  std::fill(tenants_.begin(), tenants_.end(), tenant_counters{});
+  clock_ = 0;
+}
+
+// Puts an element in its belonged set inside cache, on behalf of the current
+// tenant.
+// Also prints the current allocation attempt and returns whether it was a hit.
+// The Old cache line content printed is the one of the way used.
+// This is the main interaction function.
+inline bool shared_cache::allocate(const address& value) {
+  auto id{get_id(value)};
+  auto first{id * ways_};
+  auto tag{index_.tag(value)};
+  auto way{find(first, tag)};
+  auto found{way != ways_};
+  auto line{first + (found ? way : replace(first))};
+  auto valid{tags_.valid(line)};
+  auto old{valid ? static_cast<address>(index_.rebuild(tags_[line], id))
+                 : empty_space};
+  auto& tenant{tenants_[tenant_]};
+
+  record(value, found, id, old, (found ? empty_space : old));
+  if (found) {
+    ++tenant.hits;
+    ++hit_count_;
+  } else {
+    if (valid) {
+      auto& owner{tenants_[owners_[line]]};
+      ++tenant.evictions;
+      owner.interference += &owner != &tenant;
+      --owner.lines;
+    }
+    tags_.set(line, tag);
+    owners_[line] = static_cast<std::uint8_t>(tenant_);
+    ++tenant.lines;
+    ++tenant.misses;
+    ++miss_count_;
+  }
+  uses_[line] = ++clock_;
+
+  return found;
+}
+
+// Returns the id of the set in which the new ellement should be allocated.
+inline int shared_cache::get_id(const address& value) const noexcept {
+  return index_(value);
+}
+
+// Builds the sets of the current size, emptied. Every tenant may fill any
+// way.
+inline void shared_cache::build_sets() {
+  set_count_ = associative_set_count(items_count_);
+  ways_ = items_count_ / set_count_;
+  index_ = set_index(index_.policy(), set_count_);
+  tags_ = tag_array(set_count_ * ways_, index_.tag_bits(address_bits_));
+  owners_.assign(set_count_ * ways_, 0);
+  uses_.assign(set_count_ * ways_, 0);
+  for (auto& mask : masks_) {
+    mask.assign((ways_ + 63) / 64, ~std::uint64_t{0});
+    if (ways_ % 64) {
+      mask.back() = (std::uint64_t{1} << (ways_ % 64)) - 1;
+    }
+  }
+}
+
+// Returns whether the current tenant may fill a way.
+inline bool shared_cache::allowed(const std::size_t& way) const noexcept {
+  return masks_[tenant_][way / 64] >> (way % 64) & 1;
+}
+
+// Returns the way of the set starting at first holding the tag, or ways_ if
+// it is not there. Ways are searched with the vectorized tag kernels, skipping
+// the stale tags of empty ways.
+inline std::size_t shared_cache::find(const std::size_t& first,
+                                      const std::uint64_t& tag) const
+    noexcept {
+  std::size_t way = 0;
+
+  while ((way += tags_.find(first + way, ways_ - way, tag)) < ways_) {
+    if (tags_.valid(first + way)) {
+      return way;
+    }
+    ++way;
+  }
+  return ways_;
+}
+
+// Returns which of the ways the current tenant may fill should receive a new
+// element: the first empty one if any, else the least (LRU) or most (MRU)
+// recently used one.
+inline std::size_t shared_cache::replace(const std::size_t& first) const
+    noexcept {
+  auto chosen{ways_};
+
+  for (std::size_t way = 0; way < ways_; ++way) {
+    if (!allowed(way)) {
+      continue;
+    }
+    if (!tags_.valid(first + way)) {
+      return way;
+    }
+    if (chosen == ways_ ||
+        (policy_ == MRU ? uses_[first + way] > uses_[first + chosen]
+                        : uses_[first + way] < uses_[first + chosen])) {
+      chosen = way;
+    }
+  }
+  return chosen;
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_SHARED_CACHE_H_
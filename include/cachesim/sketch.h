@@ -0,0 +1,262 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_SKETCH_H_
+#define CACHESIM_SKETCH_H_
+
+#include <cachesim/tag_search.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace cachesim {
+
+// Rows of a count-min sketch, one hash function per row.
+constexpr const std::size_t sketch_depth = 4;
+
+// Default counters per row of a count-min sketch.
+constexpr const std::size_t sketch_width = 1 << 14;
+
+// Mixes the bits of a key (splitmix64 finalizer), so that close addresses
+// spread over the whole sketch.
+inline std::uint64_t mix_key(std::uint64_t key) noexcept {
+  key ^= key >> 30;
+  key *= 0xbf58476d1ce4e5b9;
+  key ^= key >> 27;
+  key *= 0x94d049bb133111eb;
+  return key ^ (key >> 31);
+}
+
+// class count_min_sketch
+// Estimates how many times every key was added in a fixed amount of memory:
+// sketch_depth rows of counters, every key counted once per row in the
+// counter chosen by the hash of the row. The estimate is the smallest of its
+// counters, which never undercounts.
+// Counters are increased with conservative update: only the counters equal
+// to the estimate grow, which keeps the overcount of rare keys low.
+class count_min_sketch {
+ public:
+  // ctor
+  explicit count_min_sketch(const std::size_t& width = sketch_width);
+  // accessors
+  std::uint64_t estimate(const std::uint64_t& key) const noexcept;
+  // mutators
+  std::uint64_t add(const std::uint64_t& key) noexcept;
+  void clear() noexcept;
+
+ private:
+  std::size_t slot(const std::size_t& row,
+                   const std::uint64_t& mixed) const noexcept;
+  // member variables
+  unsigned bits_;                        // log2 of the counters per row
+  std::vector<std::uint64_t> counters_;  // rows, one after another
+};
+
+// Explicit ctor
+// Rounds the width up to a power of 2.
+inline count_min_sketch::count_min_sketch(const std::size_t& width)
+    : bits_(1) {
+  while ((std::size_t{1} << bits_) < width) {
+    ++bits_;
+  }
+  counters_.assign(sketch_depth << bits_, 0);
+}
+
+// Returns the estimated count of a key.
+inline std::uint64_t count_min_sketch::estimate(const std::uint64_t& key) const
+    noexcept {
+  auto mixed{mix_key(key)};
+  auto count{counters_[slot(0, mixed)]};
+
+  for (std::size_t row = 1; row < sketch_depth; ++row) {
+    count = std::min(count, counters_[slot(row, mixed)]);
+  }
+  return count;
+}
+
+// Counts the key once more and returns its new estimated count.
+inline std::uint64_t count_min_sketch::add(const std::uint64_t& key) noexcept {
+  auto mixed{mix_key(key)};
+  std::size_t slots[sketch_depth];
+  auto count{~std::uint64_t{0}};
+
+  for (std::size_t row = 0; row < sketch_depth; ++row) {
+    slots[row] = slot(row, mixed);
+    count = std::min(count, counters_[slots[row]]);
+  }
+  for (std::size_t row = 0; row < sketch_depth; ++row) {
+    if (counters_[slots[row]] == count) {
+      ++counters_[slots[row]];
+    }
+  }
+  return count + 1;
+}
+
+// Zeroes every counter.
+inline void count_min_sketch::clear() noexcept {
+  std::fill(counters_.begin(), counters_.end(), 0);
+}
+
+// Returns the counter of a row for a mixed key. Every row multiplies the key
+// by its own odd constant and keeps the top bits.
+inline std::size_t count_min_sketch::slot(const std::size_t& row,
+                                          const std::uint64_t& mixed) const
+    noexcept {
+  constexpr const std::uint64_t seeds[sketch_depth] = {
+      0x9e3779b97f4a7c15, 0xc2b2ae3d27d4eb4f, 0x165667b19e3779f9,
+      0xd6e8feb86659fd93};
+  return (row << bits_) + static_cast<std::size_t>(
+                              (mixed * seeds[row]) >> (64 - bits_));
+}
+
+// struct heavy_hitter
+// Key kept by a heavy_hitters structure, with the item it stands for.
+template <typename T>
+struct heavy_hitter {
+  T item;               // counted item
+  std::uint64_t count;  // estimated count of the item
+};
+
+// class heavy_hitters
+// Keeps the k items with the highest counts among all the items added, in
+// bounded memory, with the space-saving algorithm: once k items are kept, a
+// new item replaces the kept item with the lowest count.
+// Counts are the estimates of a count_min_sketch, so a new item only replaces
+// a kept one when it was actually seen more often, instead of inheriting the
+// count of the replaced item.
+// Kept items are stored as a min-heap on their counts. Their keys are stored
+// apart, so that a key is found with the vectorized tag kernels, and every
+// addition costs the sketch update, a scan of k keys and a heap update.
+template <typename T>
+class heavy_hitters {
+ public:
+  // ctor
+  explicit heavy_hitters(const std::size_t& k,
+                         const std::size_t& width = sketch_width);
+  // accessors
+  std::size_t capacity() const noexcept;
+  std::uint64_t total() const noexcept;
+  std::vector<heavy_hitter<T>> top() const;
+  // mutators
+  void add(const std::uint64_t& key, const T& item);
+  void clear() noexcept;
+
+ private:
+  void sift_down(std::size_t i) noexcept;
+  void sift_up(std::size_t i) noexcept;
+  void swap(const std::size_t& i, const std::size_t& j) noexcept;
+  // member variables
+  std::size_t k_;                         // max items kept
+  std::uint64_t total_;                   // items added
+  count_min_sketch sketch_;               // counts of every key
+  std::vector<std::uint64_t> keys_;       // keys of the kept items
+  std::vector<heavy_hitter<T>> hitters_;  // kept items, as a min-heap
+};
+
+// Explicit ctor
+// Keeps at least one item.
+template <typename T>
+heavy_hitters<T>::heavy_hitters(const std::size_t& k, const std::size_t& width)
+    : k_(std::max<std::size_t>(k, 1)), total_(0), sketch_(width) {
+  keys_.reserve(k_);
+  hitters_.reserve(k_);
+}
+
+// Returns the max number of items kept.
+template <typename T>
+std::size_t heavy_hitters<T>::capacity() const noexcept {
+  return k_;
+}
+
+// Returns the number of items added.
+template <typename T>
+std::uint64_t heavy_hitters<T>::total() const noexcept {
+  return total_;
+}
+
+// Returns the kept items, highest count first.
+template <typename T>
+std::vector<heavy_hitter<T>> heavy_hitters<T>::top() const {
+  auto sorted{hitters_};
+
+  std::sort(sorted.begin(), sorted.end(),
+            [](const heavy_hitter<T>& a, const heavy_hitter<T>& b) {
+              return a.count > b.count;
+            });
+  return sorted;
+}
+
+// Counts an item, identified by its key.
+template <typename T>
+void heavy_hitters<T>::add(const std::uint64_t& key, const T& item) {
+  auto count{sketch_.add(key)};
+  auto i{simd::find_tag(keys_.data(), keys_.size(), key)};
+
+  ++total_;
+  if (i != keys_.size()) {
+    hitters_[i].count = count;
+    sift_down(i);
+  } else if (hitters_.size() < k_) {
+    keys_.push_back(key);
+    hitters_.push_back({item, count});
+    sift_up(hitters_.size() - 1);
+  } else if (count > hitters_[0].count) {
+    keys_[0] = key;
+    hitters_[0] = {item, count};
+    sift_down(0);
+  }
+}
+
+// Forgets every item and count.
+template <typename T>
+void heavy_hitters<T>::clear() noexcept {
+  sketch_.clear();
+  keys_.clear();
+  hitters_.clear();
+  total_ = 0;
+}
+
+// Moves the i-th kept item down the heap until no child has a lower count.
+template <typename T>
+void heavy_hitters<T>::sift_down(std::size_t i) noexcept {
+  for (;;) {
+    auto lowest{i};
+    auto left{2 * i + 1};
+    auto right{left + 1};
+    if (left < hitters_.size() &&
+        hitters_[left].count < hitters_[lowest].count) {
+      lowest = left;
+    }
+    if (right < hitters_.size() &&
+        hitters_[right].count < hitters_[lowest].count) {
+      lowest = right;
+    }
+    if (lowest == i) {
+      return;
+    }
+    swap(i, lowest);
+    i = lowest;
+  }
+}
+
+// Moves the i-th kept item up the heap until its parent has a lower count.
+template <typename T>
+void heavy_hitters<T>::sift_up(std::size_t i) noexcept {
+  while (i && hitters_[i].count < hitters_[(i - 1) / 2].count) {
+    swap(i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+// Swaps two kept items along with their keys.
+template <typename T>
+void heavy_hitters<T>::swap(const std::size_t& i,
+                            const std::size_t& j) noexcept {
+  std::swap(keys_[i], keys_[j]);
+  std::swap(hitters_[i], hitters_[j]);
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_SKETCH_H_
@@ -0,0 +1,164 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_SKEWED_ASSOCIATIVE_CACHE_H_
+#define CACHESIM_SKEWED_ASSOCIATIVE_CACHE_H_
+
+#include <cachesim/cache_.h>
+#include <cachesim/set_index.h>
+
+#include <cstdint>
+
+namespace cachesim {
+
+// Max number of ways of a skewed-associative cache.
+constexpr const std::size_t skewed_ways = 4;
+
+// class skewed_associative_cache
+// Represents a skewed-associative mapped cache.
+// Every way is a bank of lines with its own XOR_FOLD skew, so addresses that
+// conflict in one way are usually spread in the others. An address can live
+// in one line of each way; the replaced line is chosen among those with the
+// emplace policy, using the time of the last use of every line.
+// Inherits from cache.
+class skewed_associative_cache final : public cache {
+ public:
+  // ctor
+  skewed_associative_cache();
+  explicit skewed_associative_cache(const std::size_t& size,
+                                    const std::size_t& line_size,
+                                    const int& policy, std::ostream& os,
+                                    const bool& hex);
+  ~skewed_associative_cache() = default;
+  // accessors
+  std::size_t way_count() const noexcept;
+  // mutators
+  void clear() override final;
+  void resize(const std::size_t& size,
+              const std::size_t& line_size) override final;
+  bool allocate(const address& value) override final;
+
+ private:
+  int get_id(const address& value) const noexcept override final;
+  void build_banks();
+  std::size_t replace(const std::size_t* lines) const noexcept;
+  // member variables
+  std::size_t ways_;                 // number of ways
+  std::size_t bank_size_;            // number of lines in a way
+  std::vector<set_index> indexes_;   // address to line mapping of every way
+  cache_set items_;                  // lines of every way, one after another
+  std::vector<std::uint64_t> uses_;  // time of the last use of every line
+  std::uint64_t clock_;              // current time
+};
+
+// Default ctor
+// Creates a 1 way, 1 line cache.
+inline skewed_associative_cache::skewed_associative_cache()
+    : cache(), clock_(0) {
+  build_banks();
+}
+
+// Explicit ctor
+// Creates a cache of up to skewed_ways ways.
+// The sizes check is performed under the cache ctor.
+inline skewed_associative_cache::skewed_associative_cache(
+    const std::size_t& size, const std::size_t& line_size, const int& policy,
+    std::ostream& os, const bool& hex)
+    : cache(size, line_size, policy, os, hex), clock_(0) {
+  build_banks();
+}
+
+// Returns the number of ways of the cache.
+inline std::size_t skewed_associative_cache::way_count() const noexcept {
+  return ways_;
+}
+
+// Wipes all lines.
+inline void skewed_associative_cache::clear() {
+  std::fill(items_.begin(), items_.end(), empty_space);
+  std::fill(uses_.begin(), uses_.end(), 0);
+  clock_ = 0;
+  hit_count_ = 0;
+  miss_count_ = 0;
+}
+
+// Resizes the cache and the ways after checking the sizes.
+inline void skewed_associative_cache::resize(const std::size_t& size,
+                                             const std::size_t& line_size) {
+  set_size(size, line_size);
+  clock_ = 0;
+  build_banks();
+}
+
+// Puts an element in one of the lines it maps to.
+// Also prints the current allocation attempt and returns whether it was a hit.
+// The Set ID printed is the line used, counting the lines of all ways.
+// This is the main interaction function.
+inline bool skewed_associative_cache::allocate(const address& value) {
+  std::size_t lines[skewed_ways];
+  std::size_t line = 0;
+  auto found{false};
+
+  for (std::size_t way = 0; way < ways_; ++way) {
+    lines[way] = way * bank_size_ + indexes_[way](value);
+    if (!found && items_[lines[way]] == value) {
+      line = lines[way];
+      found = true;
+    }
+  }
+
+  if (!found) {
+    line = replace(lines);
+  }
+  record(value, found, line, items_[line],
+         (found ? empty_space : items_[line]));
+  items_[line] = value;
+  uses_[line] = ++clock_;
+  if (found) {
+    ++hit_count_;
+  } else {
+    ++miss_count_;
+  }
+
+  return found;
+}
+
+// Returns the line of the first way in which the new element could be
+// allocated.
+inline int skewed_associative_cache::get_id(const address& value) const
+    noexcept {
+  return indexes_[0](value);
+}
+
+// Splits the lines into the ways and empties them.
+inline void skewed_associative_cache::build_banks() {
+  ways_ = std::min(skewed_ways, items_count_);
+  bank_size_ = items_count_ / ways_;
+  indexes_.clear();
+  for (std::size_t way = 0; way < ways_; ++way) {
+    indexes_.emplace_back(XOR_FOLD, bank_size_, way);
+  }
+  items_.assign(ways_ * bank_size_, empty_space);
+  uses_.assign(items_.size(), 0);
+}
+
+// Returns which of the lines an address maps to should receive it: the first
+// empty line if any, else the least (LRU) or most (MRU) recently used one.
+inline std::size_t skewed_associative_cache::replace(
+    const std::size_t* lines) const noexcept {
+  auto chosen{lines[0]};
+
+  for (std::size_t way = 0; way < ways_; ++way) {
+    auto line{lines[way]};
+    if (items_[line] == empty_space) {
+      return line;
+    }
+    if (policy_ == MRU ? uses_[line] > uses_[chosen]
+                       : uses_[line] < uses_[chosen]) {
+      chosen = line;
+    }
+  }
+  return chosen;
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_SKEWED_ASSOCIATIVE_CACHE_H_
@@ -0,0 +1,219 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_TAG_ARRAY_H_
+#define CACHESIM_TAG_ARRAY_H_
+
+#include <cachesim/tag_search.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace cachesim {
+
+// Returns the number of trailing zero bits of a nonzero word.
+inline std::size_t count_trailing_zeros(const std::uint64_t& word) noexcept {
+#if defined(__GNUC__)
+  return static_cast<std::size_t>(__builtin_ctzll(word));
+#else
+  std::size_t n = 0;
+  while (!(word >> n & 1)) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// class tag_array
+// Stores the tags of the lines of a cache in the narrowest width holding them
+// (8, 16, 32 or 64 bits), with the validity of every line kept apart in a
+// bitmap. Only the array of the current width is allocated.
+// The width is chosen from the tag bits expected by the cache geometry. A tag
+// which doesn't fit widens the whole array, so unexpected addresses are
+// still simulated correctly.
+class tag_array {
+ public:
+  // ctor
+  tag_array();
+  explicit tag_array(const std::size_t& n, const unsigned& bits);
+  // accessors
+  std::size_t size() const noexcept;
+  std::size_t width() const noexcept;
+  bool valid(const std::size_t& i) const noexcept;
+  std::uint64_t operator[](const std::size_t& i) const noexcept;
+  std::size_t find(const std::size_t& first, const std::size_t& n,
+                   const std::uint64_t& tag) const noexcept;
+  std::size_t find_empty(const std::size_t& first,
+                         const std::size_t& n) const noexcept;
+  // mutators
+  void set(const std::size_t& i, const std::uint64_t& tag);
+  void rotate(const std::size_t& first, const std::size_t& middle,
+              const std::size_t& last) noexcept;
+  void clear() noexcept;
+
+ private:
+  template <typename Visitor>
+  auto visit(Visitor f) const;
+  template <typename Visitor>
+  auto visit(Visitor f);
+  void set_width(const unsigned& bits);
+  void widen(const std::uint64_t& tag);
+  // member variables
+  std::size_t size_;                   // number of lines
+  std::size_t width_;                  // bytes per tag
+  std::uint64_t max_;                  // largest tag fitting the width
+  std::vector<std::uint8_t> tags8_;    // tags, if 8-bit wide
+  std::vector<std::uint16_t> tags16_;  // tags, if 16-bit wide
+  std::vector<std::uint32_t> tags32_;  // tags, if 32-bit wide
+  std::vector<std::uint64_t> tags64_;  // tags, if 64-bit wide
+  std::vector<std::uint64_t> valid_;   // validity bitmap
+};
+
+// Calls f with the array of the current width.
+template <typename Visitor>
+auto tag_array::visit(Visitor f) const {
+  switch (width_) {
+    case 1:
+      return f(tags8_);
+    case 2:
+      return f(tags16_);
+    case 4:
+      return f(tags32_);
+    default:
+      return f(tags64_);
+  }
+}
+
+template <typename Visitor>
+auto tag_array::visit(Visitor f) {
+  switch (width_) {
+    case 1:
+      return f(tags8_);
+    case 2:
+      return f(tags16_);
+    case 4:
+      return f(tags32_);
+    default:
+      return f(tags64_);
+  }
+}
+
+// Default ctor
+// Creates a single invalid 8-bit tag.
+inline tag_array::tag_array() : tag_array(1, 8) {}
+
+// Explicit ctor
+// Creates n invalid tags of the narrowest width holding the given bits.
+inline tag_array::tag_array(const std::size_t& n, const unsigned& bits)
+    : size_(n), width_(0), max_(0), valid_((n + 63) / 64, 0) {
+  set_width(bits);
+}
+
+// Returns the number of tags.
+inline std::size_t tag_array::size() const noexcept { return size_; }
+
+// Returns the bytes used by every tag.
+inline std::size_t tag_array::width() const noexcept { return width_; }
+
+// Returns whether the i-th line holds a tag.
+inline bool tag_array::valid(const std::size_t& i) const noexcept {
+  return valid_[i / 64] >> (i % 64) & 1;
+}
+
+// Returns the i-th tag. Invalid lines return their stale tag.
+inline std::uint64_t tag_array::operator[](const std::size_t& i) const
+    noexcept {
+  return visit([&](const auto& tags) -> std::uint64_t { return tags[i]; });
+}
+
+// Returns the position of the given tag among the n tags from first, or n if
+// it isn't there. The n tags must be valid.
+inline std::size_t tag_array::find(const std::size_t& first,
+                                   const std::size_t& n,
+                                   const std::uint64_t& tag) const noexcept {
+  if (tag > max_) {
+    return n;
+  }
+  return visit([&](const auto& tags) {
+    using value_type = typename std::decay_t<decltype(tags)>::value_type;
+    return simd::find_tag(tags.data() + first, n,
+                          static_cast<value_type>(tag));
+  });
+}
+
+// Returns the position of the first invalid line among the n lines from
+// first, or n if all of them are valid. The bitmap is scanned a word at a
+// time, taking the lowest clear bit of every word.
+inline std::size_t tag_array::find_empty(const std::size_t& first,
+                                         const std::size_t& n) const noexcept {
+  auto last{first + n};
+
+  for (auto i{first}; i < last; i = (i / 64 + 1) * 64) {
+    auto empty{~valid_[i / 64] >> (i % 64)};
+    if (empty) {
+      return std::min(i + count_trailing_zeros(empty), last) - first;
+    }
+  }
+  return n;
+}
+
+// Stores a tag in the i-th line and marks it as valid.
+inline void tag_array::set(const std::size_t& i, const std::uint64_t& tag) {
+  if (tag > max_) {
+    widen(tag);
+  }
+  visit([&](auto& tags) {
+    using value_type = typename std::decay_t<decltype(tags)>::value_type;
+    tags[i] = static_cast<value_type>(tag);
+  });
+  valid_[i / 64] |= std::uint64_t{1} << (i % 64);
+}
+
+// Rotates the tags in [first, last) so that middle becomes the first one.
+// The lines must share their validity.
+inline void tag_array::rotate(const std::size_t& first,
+                              const std::size_t& middle,
+                              const std::size_t& last) noexcept {
+  visit([&](auto& tags) {
+    std::rotate(tags.begin() + first, tags.begin() + middle,
+                tags.begin() + last);
+  });
+}
+
+// Invalidates every line. Tags keep their width.
+inline void tag_array::clear() noexcept {
+  std::fill(valid_.begin(), valid_.end(), 0);
+}
+
+// Allocates the array of the narrowest width holding the given bits, freeing
+// the others. Tags are zeroed.
+inline void tag_array::set_width(const unsigned& bits) {
+  width_ = bits <= 8 ? 1 : bits <= 16 ? 2 : bits <= 32 ? 4 : 8;
+  max_ = width_ < 8 ? (std::uint64_t{1} << (8 * width_)) - 1
+                    : ~std::uint64_t{0};
+  std::vector<std::uint8_t>().swap(tags8_);
+  std::vector<std::uint16_t>().swap(tags16_);
+  std::vector<std::uint32_t>().swap(tags32_);
+  std::vector<std::uint64_t>().swap(tags64_);
+  visit([&](auto& tags) { tags.resize(size_); });
+}
+
+// Moves the tags to the narrowest width holding the given tag.
+inline void tag_array::widen(const std::uint64_t& tag) {
+  std::vector<std::uint64_t> tags(size_);
+  unsigned bits = 0;
+
+  for (std::size_t i = 0; i < size_; ++i) {
+    tags[i] = (*this)[i];
+  }
+  while (bits < 64 && tag >> bits) {
+    ++bits;
+  }
+  set_width(bits);
+  visit([&](auto& wide) { std::copy(tags.begin(), tags.end(), wide.begin()); });
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_TAG_ARRAY_H_
@@ -0,0 +1,335 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_TAG_SEARCH_H_
+#define CACHESIM_TAG_SEARCH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CACHESIM_TAG_SEARCH_X86_
+#include <immintrin.h>
+#endif
+
+namespace cachesim {
+namespace simd {
+
+// enum isa
+// Defines the instruction set used by the tag search kernels.
+enum isa { SCALAR, SSE42, AVX2 };
+
+// Function types of the tag search kernels.
+using find8_fn = std::size_t (*)(const std::int8_t*, std::size_t,
+                                 std::int8_t) noexcept;
+using find16_fn = std::size_t (*)(const std::int16_t*, std::size_t,
+                                  std::int16_t) noexcept;
+using find32_fn = std::size_t (*)(const std::int32_t*, std::size_t,
+                                  std::int32_t) noexcept;
+using find64_fn = std::size_t (*)(const std::int64_t*, std::size_t,
+                                  std::int64_t) noexcept;
+
+// Scalar kernels.
+// Returns the position of the first tag equal to the given one, or n if there
+// is no such tag.
+template <typename T>
+std::size_t find_scalar(const T* tags, std::size_t n, T tag) noexcept {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (tags[i] == tag) {
+      return i;
+    }
+  }
+  return n;
+}
+
+inline std::size_t find8_scalar(const std::int8_t* tags, std::size_t n,
+                                std::int8_t tag) noexcept {
+  return find_scalar(tags, n, tag);
+}
+
+inline std::size_t find16_scalar(const std::int16_t* tags, std::size_t n,
+                                 std::int16_t tag) noexcept {
+  return find_scalar(tags, n, tag);
+}
+
+inline std::size_t find32_scalar(const std::int32_t* tags, std::size_t n,
+                                 std::int32_t tag) noexcept {
+  return find_scalar(tags, n, tag);
+}
+
+inline std::size_t find64_scalar(const std::int64_t* tags, std::size_t n,
+                                 std::int64_t tag) noexcept {
+  return find_scalar(tags, n, tag);
+}
+
+#ifdef CACHESIM_TAG_SEARCH_X86_
+// SSE4.2 kernels.
+// Compares 16 (8-bit), 8 (16-bit), 4 (32-bit) or 2 (64-bit) tags per step and
+// finishes the tail with the scalar kernel. The 16-bit kernels get two mask
+// bits per tag.
+inline __attribute__((target("sse4.2"))) std::size_t find8_sse42(
+    const std::int8_t* tags, std::size_t n, std::int8_t tag) noexcept {
+  const __m128i key = _mm_set1_epi8(tag);
+  std::size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + i));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, key));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + find_scalar(tags + i, n - i, tag);
+}
+
+inline __attribute__((target("sse4.2"))) std::size_t find16_sse42(
+    const std::int16_t* tags, std::size_t n, std::int16_t tag) noexcept {
+  const __m128i key = _mm_set1_epi16(tag);
+  std::size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + i));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(v, key));
+    if (mask) {
+      return i + __builtin_ctz(mask) / 2;
+    }
+  }
+
+  return i + find_scalar(tags + i, n - i, tag);
+}
+
+inline __attribute__((target("sse4.2"))) std::size_t find32_sse42(
+    const std::int32_t* tags, std::size_t n, std::int32_t tag) noexcept {
+  const __m128i key = _mm_set1_epi32(tag);
+  std::size_t i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + i));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, key)));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + find_scalar(tags + i, n - i, tag);
+}
+
+inline __attribute__((target("sse4.2"))) std::size_t find64_sse42(
+    const std::int64_t* tags, std::size_t n, std::int64_t tag) noexcept {
+  const __m128i key = _mm_set1_epi64x(tag);
+  std::size_t i = 0;
+
+  for (; i + 2 <= n; i += 2) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + i));
+    int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(v, key)));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + find_scalar(tags + i, n - i, tag);
+}
+
+// AVX2 kernels.
+// Compares 32 (8-bit), 16 (16-bit), 8 (32-bit) or 4 (64-bit) tags per step and
+// finishes the tail with the scalar kernel.
+inline __attribute__((target("avx2"))) std::size_t find8_avx2(
+    const std::int8_t* tags, std::size_t n, std::int8_t tag) noexcept {
+  const __m256i key = _mm256_set1_epi8(tag);
+  std::size_t i = 0;
+
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + i));
+    auto mask{static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, key)))};
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + find_scalar(tags + i, n - i, tag);
+}
+
+inline __attribute__((target("avx2"))) std::size_t find16_avx2(
+    const std::int16_t* tags, std::size_t n, std::int16_t tag) noexcept {
+  const __m256i key = _mm256_set1_epi16(tag);
+  std::size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + i));
+    auto mask{static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi16(v, key)))};
+    if (mask) {
+      return i + __builtin_ctz(mask) / 2;
+    }
+  }
+
+  return i + find_scalar(tags + i, n - i, tag);
+}
+
+inline __attribute__((target("avx2"))) std::size_t find32_avx2(
+    const std::int32_t* tags, std::size_t n, std::int32_t tag) noexcept {
+  const __m256i key = _mm256_set1_epi32(tag);
+  std::size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + i));
+    int mask =
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, key)));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + find_scalar(tags + i, n - i, tag);
+}
+
+inline __attribute__((target("avx2"))) std::size_t find64_avx2(
+    const std::int64_t* tags, std::size_t n, std::int64_t tag) noexcept {
+  const __m256i key = _mm256_set1_epi64x(tag);
+  std::size_t i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + i));
+    int mask =
+        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, key)));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + find_scalar(tags + i, n - i, tag);
+}
+#endif  // CACHESIM_TAG_SEARCH_X86_
+
+// Returns the best instruction set supported by the running CPU.
+inline isa detect_isa() noexcept {
+#ifdef CACHESIM_TAG_SEARCH_X86_
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return SSE42;
+  }
+#endif
+  return SCALAR;
+}
+
+// Returns the instruction set selected for this process.
+// The CPU is only queried once, the first time a kernel is requested.
+inline isa active_isa() noexcept {
+  static const isa selected = detect_isa();
+  return selected;
+}
+
+// Returns the 8-bit kernel for the given instruction set.
+inline find8_fn select_find8(const isa& set) noexcept {
+  switch (set) {
+#ifdef CACHESIM_TAG_SEARCH_X86_
+    case AVX2:
+      return find8_avx2;
+    case SSE42:
+      return find8_sse42;
+#endif
+    default:
+      return find8_scalar;
+  }
+}
+
+// Returns the 16-bit kernel for the given instruction set.
+inline find16_fn select_find16(const isa& set) noexcept {
+  switch (set) {
+#ifdef CACHESIM_TAG_SEARCH_X86_
+    case AVX2:
+      return find16_avx2;
+    case SSE42:
+      return find16_sse42;
+#endif
+    default:
+      return find16_scalar;
+  }
+}
+
+// Returns the 32-bit kernel for the given instruction set.
+inline find32_fn select_find32(const isa& set) noexcept {
+  switch (set) {
+#ifdef CACHESIM_TAG_SEARCH_X86_
+    case AVX2:
+      return find32_avx2;
+    case SSE42:
+      return find32_sse42;
+#endif
+    default:
+      return find32_scalar;
+  }
+}
+
+// Returns the 64-bit kernel for the given instruction set.
+inline find64_fn select_find64(const isa& set) noexcept {
+  switch (set) {
+#ifdef CACHESIM_TAG_SEARCH_X86_
+    case AVX2:
+      return find64_avx2;
+    case SSE42:
+      return find64_sse42;
+#endif
+    default:
+      return find64_scalar;
+  }
+}
+
+// Returns the position of the first of the n tags equal to the given tag, or n
+// if the tag is not present. Uses the kernel selected for the running CPU.
+inline std::size_t find_tag(const std::int8_t* tags, std::size_t n,
+                            std::int8_t tag) noexcept {
+  static const find8_fn kernel = select_find8(active_isa());
+  return kernel(tags, n, tag);
+}
+
+inline std::size_t find_tag(const std::int16_t* tags, std::size_t n,
+                            std::int16_t tag) noexcept {
+  static const find16_fn kernel = select_find16(active_isa());
+  return kernel(tags, n, tag);
+}
+
+inline std::size_t find_tag(const std::int32_t* tags, std::size_t n,
+                            std::int32_t tag) noexcept {
+  static const find32_fn kernel = select_find32(active_isa());
+  return kernel(tags, n, tag);
+}
+
+inline std::size_t find_tag(const std::int64_t* tags, std::size_t n,
+                            std::int64_t tag) noexcept {
+  static const find64_fn kernel = select_find64(active_isa());
+  return kernel(tags, n, tag);
+}
+
+// Unsigned tags compare the same way as their signed counterparts.
+inline std::size_t find_tag(const std::uint8_t* tags, std::size_t n,
+                            std::uint8_t tag) noexcept {
+  return find_tag(reinterpret_cast<const std::int8_t*>(tags), n,
+                  static_cast<std::int8_t>(tag));
+}
+
+inline std::size_t find_tag(const std::uint16_t* tags, std::size_t n,
+                            std::uint16_t tag) noexcept {
+  return find_tag(reinterpret_cast<const std::int16_t*>(tags), n,
+                  static_cast<std::int16_t>(tag));
+}
+
+inline std::size_t find_tag(const std::uint32_t* tags, std::size_t n,
+                            std::uint32_t tag) noexcept {
+  return find_tag(reinterpret_cast<const std::int32_t*>(tags), n,
+                  static_cast<std::int32_t>(tag));
+}
+
+inline std::size_t find_tag(const std::uint64_t* tags, std::size_t n,
+                            std::uint64_t tag) noexcept {
+  return find_tag(reinterpret_cast<const std::int64_t*>(tags), n,
+                  static_cast<std::int64_t>(tag));
+}
+
+}  // namespace simd
+}  // namespace cachesim
+
+#endif  // CACHESIM_TAG_SEARCH_H_
@@ -0,0 +1,227 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_TLB_H_
+#define CACHESIM_TLB_H_
+
+#include <cachesim/cache_.h>
+#include <cachesim/error.h>
+#include <cachesim/set_index.h>
+#include <cachesim/tag_array.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace cachesim {
+
+// Width of the translated virtual addresses, as in x86-64 and AArch64.
+constexpr const unsigned virtual_address_bits = 48;
+
+// Bits of the virtual address resolved by every page table level.
+constexpr const unsigned page_table_bits = 9;
+
+// Smallest and largest page sizes (4K and 1G).
+constexpr const std::size_t min_page_size = std::size_t{1} << 12;
+constexpr const std::size_t max_page_size = std::size_t{1} << 30;
+
+// Virtual address of the page tables, above every translated address. Every
+// page table level gets its own region of page_table_region bytes.
+constexpr const std::uint64_t page_table_base = std::uint64_t{1}
+                                                << virtual_address_bits;
+constexpr const std::uint64_t page_table_region = std::uint64_t{1} << 40;
+
+// struct tlb_counters
+// Counters of the lookups of a TLB level.
+struct tlb_counters {
+  std::uint64_t hits;    // translations found in the level
+  std::uint64_t misses;  // translations missing in the level
+};
+
+// class tlb
+// Represents a multi-level TLB in front of the data cache.
+// Every level is a set-associative array of translations (virtual page
+// numbers) stored like the sets of a set_associative_cache: a flat tag array
+// where the filled ways of a set are ordered from least to most recently
+// used, replaced with the emplace policy.
+// Levels are looked up in order; a translation found in a level is copied
+// into the levels before it. A translation missing in every level is
+// resolved by a page walk through a radix page table, reading one entry per
+// page table level. The entries read are passed to a visitor, which allocates
+// them in the data cache and returns whether they hit.
+class tlb {
+ public:
+  // ctor
+  explicit tlb(const std::size_t& page_size, const int& policy);
+  // accessors
+  std::size_t page_size() const noexcept;
+  std::size_t level_count() const noexcept;
+  std::size_t walk_depth() const noexcept;
+  std::uint64_t walk_count() const noexcept;
+  std::uint64_t walk_access_count() const noexcept;
+  std::uint64_t walk_miss_count() const noexcept;
+  const tlb_counters& counters(const std::size_t& level) const noexcept;
+  // mutators
+  bool add_level(const std::size_t& entries, const std::size_t& ways);
+  template <typename Visitor>
+  bool translate(const std::uint64_t& value, Visitor walk);
+
+ private:
+  // struct level
+  // Translations of a TLB level.
+  struct level {
+    std::size_t ways;       // number of translations in a set
+    set_index index;        // page to set mapping
+    tag_array tags;         // tags of the sets, one after another
+    tlb_counters counters;  // lookups of the level
+  };
+  bool lookup(level* l, const std::uint64_t& page) noexcept;
+  void fill(level* l, const std::uint64_t& page);
+  // member variables
+  unsigned page_bits_;           // log2 of the page size
+  emplace_policy policy_;        // replacement policy of every level
+  std::vector<level> levels_;    // levels, first level first
+  std::uint64_t walks_;          // page walks performed
+  std::uint64_t walk_accesses_;  // page table entries read
+  std::uint64_t walk_misses_;    // page table entries missing in the cache
+};
+
+// Explicit ctor
+// Creates a TLB without levels, where every translation needs a page walk.
+// The page size must be a power of 2 between min_page_size and max_page_size.
+inline tlb::tlb(const std::size_t& page_size, const int& policy)
+    : page_bits_(0),
+      policy_(static_cast<emplace_policy>(policy)),
+      walks_(0),
+      walk_accesses_(0),
+      walk_misses_(0) {
+  if (page_size < min_page_size || page_size > max_page_size ||
+      (page_size & (page_size - 1)) || (policy_ != LRU && policy_ != MRU)) {
+    throw std::invalid_argument(error::invalid_tlb_config);
+  }
+  while ((std::size_t{1} << page_bits_) < page_size) {
+    ++page_bits_;
+  }
+}
+
+// Returns the page size (Represented in bytes).
+inline std::size_t tlb::page_size() const noexcept {
+  return std::size_t{1} << page_bits_;
+}
+
+// Returns the number of levels.
+inline std::size_t tlb::level_count() const noexcept { return levels_.size(); }
+
+// Returns the page table entries read by a page walk: one per 9 bits of the
+// virtual page number (4 for 4K pages, 3 for 2M pages and 2 for 1G pages).
+inline std::size_t tlb::walk_depth() const noexcept {
+  return (virtual_address_bits - page_bits_ + page_table_bits - 1) /
+         page_table_bits;
+}
+
+// Returns the amount of page walks performed.
+inline std::uint64_t tlb::walk_count() const noexcept { return walks_; }
+
+// Returns the amount of page table entries read by the page walks.
+inline std::uint64_t tlb::walk_access_count() const noexcept {
+  return walk_accesses_;
+}
+
+// Returns the amount of page table entries read which missed in the cache.
+inline std::uint64_t tlb::walk_miss_count() const noexcept {
+  return walk_misses_;
+}
+
+// Returns the counters of a level.
+inline const tlb_counters& tlb::counters(const std::size_t& level) const
+    noexcept {
+  return levels_[level].counters;
+}
+
+// Adds a level after the existing ones, of entries translations split in sets
+// of the given ways. Returns false if entries is not a multiple of ways.
+inline bool tlb::add_level(const std::size_t& entries,
+                           const std::size_t& ways) {
+  if (!ways || !entries || entries % ways) {
+    return false;
+  }
+  set_index index(MODULO, entries / ways);
+  levels_.push_back({ways, index,
+                     tag_array(entries, index.tag_bits(virtual_address_bits -
+                                                       page_bits_)),
+                     tlb_counters{}});
+  return true;
+}
+
+// Translates the virtual address of a byte. If the translation needs a page
+// walk, the virtual address of every page table entry read is passed to walk,
+// root first, which returns whether the entry hit in the cache.
+// Returns whether the translation was found in any level.
+template <typename Visitor>
+bool tlb::translate(const std::uint64_t& value, Visitor walk) {
+  auto page{value >> page_bits_};
+  auto hit{levels_.size()};
+
+  for (std::size_t i = 0; i < levels_.size() && hit == levels_.size(); ++i) {
+    if (lookup(&levels_[i], page)) {
+      hit = i;
+    }
+  }
+  if (hit == levels_.size()) {
+    auto depth{walk_depth()};
+    auto virtual_address{value & ((std::uint64_t{1} << virtual_address_bits) -
+                                  1)};
+    for (std::size_t step = 0; step < depth; ++step) {
+      auto resolved{std::min<std::size_t>(page_table_bits * (step + 1),
+                                          virtual_address_bits - page_bits_)};
+      auto entry{virtual_address >> (virtual_address_bits - resolved)};
+      walk_misses_ +=
+          !walk(page_table_base + step * page_table_region + entry * 8);
+    }
+    walk_accesses_ += depth;
+    ++walks_;
+  }
+  for (std::size_t i = 0; i < hit; ++i) {
+    fill(&levels_[i], page);
+  }
+
+  return hit != levels_.size();
+}
+
+// Looks a page up in a level, making it the most recently used translation of
+// its set if it is there.
+inline bool tlb::lookup(level* l, const std::uint64_t& page) noexcept {
+  auto first{l->index(page) * l->ways};
+  auto tag{l->index.tag(page)};
+  auto fill{l->tags.find_empty(first, l->ways)};
+  auto way{l->tags.find(first, fill, tag)};
+
+  if (way == fill) {
+    ++l->counters.misses;
+    return false;
+  }
+  l->tags.rotate(first + way, first + way + 1, first + fill);
+  ++l->counters.hits;
+  return true;
+}
+
+// Puts a missing page in a level, replacing the least (LRU) or most (MRU)
+// recently used translation of its set if it is full.
+inline void tlb::fill(level* l, const std::uint64_t& page) {
+  auto first{l->index(page) * l->ways};
+  auto tag{l->index.tag(page)};
+  auto fill{l->tags.find_empty(first, l->ways)};
+
+  if (fill < l->ways) {
+    l->tags.set(first + fill, tag);
+  } else if (policy_ == LRU) {
+    l->tags.rotate(first, first + 1, first + l->ways);
+    l->tags.set(first + l->ways - 1, tag);
+  } else {
+    l->tags.set(first + l->ways - 1, tag);
+  }
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_TLB_H_
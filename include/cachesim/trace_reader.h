@@ -0,0 +1,369 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_TRACE_READER_H_
+#define CACHESIM_TRACE_READER_H_
+
+#include <cachesim/cache_.h>
+#include <cachesim/limits.h>
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace cachesim {
+
+// enum trace_format
+// Defines the formats of the data file.
+//   TEXT        decimal addresses, one per line. Every address is allocated as
+//               it is.
+//   LACKEY      output of valgrind --tool=lackey --trace-mem=yes:
+//                 I  0023c790,2
+//                  L be801950,4
+//               I (instruction fetch), L (load) and S (store) records access
+//               memory once, M (modify) records load and then store. Any other
+//               line is skipped.
+//   DRMEMTRACE  binary records of 12 bytes, as in DynamoRIO drmemtrace:
+//                 uint16 type, uint16 size, uint64 address (little endian)
+//               Types 0 (read), 1 (write), 2 (prefetch) and 3 (instruction
+//               fetch) access memory, any other type is a marker and is
+//               skipped.
+// Memory accesses of LACKEY and DRMEMTRACE traces are split in the cache lines
+// they touch, and every line is allocated by its line address (byte address
+// divided by the line size). Accesses over max_access_size bytes, or touching
+// lines whose address doesn't fit in a non-negative address, are skipped.
+// TEXT addresses can't be negative.
+// Timed TEXT files hold a timestamp before every address, on the same line.
+// The other formats use the position of every access as its timestamp.
+enum trace_format { TEXT, LACKEY, DRMEMTRACE };
+
+// Names of the trace formats, as given in the command line.
+constexpr const std::string_view trace_format_names[] = {"text", "lackey",
+                                                         "drmemtrace"};
+
+// Size of the chunks read from the data file.
+constexpr const std::size_t trace_chunk_size = 1 << 20;
+
+// Size of a DRMEMTRACE record.
+constexpr const std::size_t drmemtrace_record_size = 12;
+
+// Largest memory access of a LACKEY or DRMEMTRACE record, in bytes. Bigger
+// records are taken as corrupt.
+constexpr const std::uint64_t max_access_size = 1 << 12;
+
+// Sets the trace format named s.
+// Returns false if there is no such format.
+inline bool parse_trace_format(std::string_view s, trace_format* format) {
+  for (std::size_t i = 0; i < std::size(trace_format_names); ++i) {
+    if (s == trace_format_names[i]) {
+      *format = static_cast<trace_format>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the bits of the line addresses of 64-bit byte addresses, for the
+// given line size.
+inline unsigned line_address_bits(const std::size_t& line_size) noexcept {
+  unsigned bits = 64;
+
+  for (auto size{line_size}; size > 1 && bits > 1; size >>= 1) {
+    --bits;
+  }
+  return bits;
+}
+
+// Returns the bits of the addresses allocated from a data file of the given
+// format, for the given line size. TEXT addresses belong to the simulated
+// 16-bit memory, the others are line addresses of 64-bit byte addresses.
+inline unsigned address_bits(const trace_format& format,
+                             const std::size_t& line_size) noexcept {
+  return format == TEXT ? limits::address_bits : line_address_bits(line_size);
+}
+
+// class trace_reader
+// Streams a data file in fixed size chunks and parses the records in place,
+// passing every allocated address to a visitor. Only the unfinished record at
+// the end of a chunk is moved, to the front of the buffer, before reading the
+// next chunk.
+// Addresses can also be pulled one at a time, so that several data files are
+// read in a single pass; the addresses of a chunk are then kept until they are
+// pulled.
+class trace_reader {
+ public:
+  // ctor
+  explicit trace_reader(std::istream& is, const trace_format& format,
+                        const std::size_t& line_size,
+                        const bool& timed = false);
+  // accessors
+  std::uint64_t timestamp() const noexcept;
+  // mutators
+  template <typename Visitor>
+  void read(Visitor visit);
+  bool next(address* value, std::uint64_t* time);
+
+ private:
+  // struct timed_address
+  // Address pulled from the chunk, with the timestamp of its access.
+  struct timed_address {
+    std::uint64_t time;
+    address value;
+  };
+  template <typename Visitor>
+  bool read_chunk(Visitor& visit);
+  template <typename Visitor>
+  std::size_t parse_text(const char* first, const char* last, bool* done,
+                         Visitor& visit);
+  template <typename Visitor>
+  std::size_t parse_lackey(const char* first, const char* last,
+                           Visitor& visit);
+  template <typename Visitor>
+  std::size_t parse_drmemtrace(const char* first, const char* last,
+                               Visitor& visit);
+  bool fits(const std::uint64_t& addr,
+            const std::uint64_t& size) const noexcept;
+  template <typename Visitor>
+  void split(const std::uint64_t& addr, const std::uint64_t& size,
+             Visitor& visit);
+  // member variables
+  std::istream& is_;                    // data file
+  trace_format format_;                 // data file format
+  bool timed_;                          // TEXT addresses have timestamps
+  unsigned line_bits_;                  // log2 of the line size
+  std::size_t accesses_;                // memory accesses read
+  std::uint64_t time_;                  // timestamp of the current access
+  std::vector<char> buffer_;            // chunk being parsed
+  std::size_t kept_;                    // unparsed bytes kept in the buffer
+  bool done_;                           // the data file was fully parsed
+  std::vector<timed_address> pending_;  // addresses not pulled yet
+  std::size_t pulled_;                  // addresses pulled from pending_
+};
+
+// Explicit ctor
+// The line size is a power of 2, as checked by the cache.
+inline trace_reader::trace_reader(std::istream& is, const trace_format& format,
+                                  const std::size_t& line_size,
+                                  const bool& timed)
+    : is_(is),
+      format_(format),
+      timed_(timed),
+      line_bits_(0),
+      accesses_(0),
+      time_(0),
+      buffer_(trace_chunk_size),
+      kept_(0),
+      done_(false),
+      pulled_(0) {
+  while ((std::size_t{1} << (line_bits_ + 1)) <= line_size) {
+    ++line_bits_;
+  }
+}
+
+// Returns the timestamp of the access being visited.
+inline std::uint64_t trace_reader::timestamp() const noexcept { return time_; }
+
+// Reads the whole data file, passing every address to allocate to visit.
+// Reading stops at the first malformed or negative TEXT address, like it
+// always did for malformed ones, and at the end of the file.
+template <typename Visitor>
+void trace_reader::read(Visitor visit) {
+  while (read_chunk(visit)) {
+  }
+}
+
+// Pulls the next address to allocate and the timestamp of its access.
+// Returns false at the end of the data file.
+inline bool trace_reader::next(address* value, std::uint64_t* time) {
+  auto keep{[this](const address& dir) { pending_.push_back({time_, dir}); }};
+
+  while (pulled_ == pending_.size()) {
+    pending_.clear();
+    pulled_ = 0;
+    if (!read_chunk(keep)) {
+      return false;
+    }
+  }
+  *value = pending_[pulled_].value;
+  *time = pending_[pulled_++].time;
+  return true;
+}
+
+// Reads and parses the next chunk of the data file, passing its addresses to
+// visit. Returns false if the data file was already fully parsed.
+template <typename Visitor>
+bool trace_reader::read_chunk(Visitor& visit) {
+  if (done_) {
+    return false;
+  }
+  if (kept_ == buffer_.size()) {  // a record longer than a chunk
+    buffer_.resize(2 * buffer_.size());
+  }
+  is_.read(buffer_.data() + kept_, buffer_.size() - kept_);
+  auto got{static_cast<std::size_t>(is_.gcount())};
+  auto at_end{got == 0};
+
+  // At the end of the file the last record may be missing its line break.
+  if (at_end && format_ != DRMEMTRACE && kept_) {
+    buffer_[kept_] = '\n';
+    got = 1;
+  }
+  auto first{buffer_.data()};
+  auto last{first + kept_ + got};
+
+  std::size_t used = 0;
+  switch (format_) {
+    case LACKEY:
+      used = parse_lackey(first, last, visit);
+      break;
+    case DRMEMTRACE:
+      used = parse_drmemtrace(first, last, visit);
+      break;
+    default:
+      used = parse_text(first, last, &done_, visit);
+      break;
+  }
+
+  kept_ = static_cast<std::size_t>(last - first) - used;
+  std::memmove(buffer_.data(), first + used, kept_);
+  done_ = done_ || at_end;
+  return true;
+}
+
+// Parses the complete TEXT lines in [first, last), returning the amount of
+// bytes parsed. Sets done at the first malformed or negative address.
+template <typename Visitor>
+std::size_t trace_reader::parse_text(const char* first, const char* last,
+                                     bool* done, Visitor& visit) {
+  auto p{first};
+
+  for (;;) {
+    while (p != last && std::strchr(" \t\r\n\v\f", *p) && *p) {
+      ++p;
+    }
+    auto end{static_cast<const char*>(std::memchr(p, '\n', last - p))};
+    if (p == last || !end) {
+      return p - first;
+    }
+    auto number{p};
+    if (timed_) {
+      auto stamp{std::from_chars(p, end, time_)};
+      number = stamp.ptr;
+      while (stamp.ec == std::errc() && number != end &&
+             (*number == ' ' || *number == '\t')) {
+        ++number;
+      }
+      if (stamp.ec != std::errc() || number == stamp.ptr) {
+        *done = true;
+        return p - first;
+      }
+    }
+    address value = 0;
+    number = *number == '+' ? number + 1 : number;
+    auto result{std::from_chars(number, end, value)};
+    if (result.ec != std::errc() || value < 0) {
+      *done = true;
+      return p - first;
+    }
+    time_ = timed_ ? time_ : accesses_;
+    ++accesses_;
+    visit(value);
+    p = result.ptr;
+  }
+}
+
+// Parses the complete LACKEY lines in [first, last), returning the amount of
+// bytes parsed.
+template <typename Visitor>
+std::size_t trace_reader::parse_lackey(const char* first, const char* last,
+                                       Visitor& visit) {
+  auto p{first};
+
+  for (;;) {
+    auto end{static_cast<const char*>(std::memchr(p, '\n', last - p))};
+    if (!end) {
+      return p - first;
+    }
+    auto q{p};
+    while (q != end && *q == ' ') {
+      ++q;
+    }
+    auto kind{q != end ? *q : '\0'};
+    if (kind == 'I' || kind == 'L' || kind == 'S' || kind == 'M') {
+      ++q;
+      while (q != end && *q == ' ') {
+        ++q;
+      }
+      std::uint64_t addr = 0;
+      std::uint64_t size = 0;
+      auto result{std::from_chars(q, end, addr, 16)};
+      if (result.ec == std::errc() && result.ptr != end &&
+          *result.ptr == ',' &&
+          std::from_chars(result.ptr + 1, end, size).ec == std::errc() &&
+          fits(addr, size)) {
+        time_ = accesses_++;
+        split(addr, size, visit);
+        if (kind == 'M') {
+          split(addr, size, visit);
+        }
+      }
+    }
+    p = end + 1;
+  }
+}
+
+// Parses the complete DRMEMTRACE records in [first, last), returning the
+// amount of bytes parsed.
+template <typename Visitor>
+std::size_t trace_reader::parse_drmemtrace(const char* first,
+                                           const char* last, Visitor& visit) {
+  auto n{static_cast<std::size_t>(last - first) / drmemtrace_record_size};
+
+  for (std::size_t i = 0; i < n; ++i) {
+    auto record{reinterpret_cast<const unsigned char*>(first) +
+                i * drmemtrace_record_size};
+    std::uint16_t type = record[0] | record[1] << 8;
+    std::uint16_t size = record[2] | record[3] << 8;
+    std::uint64_t addr = 0;
+    for (auto byte = 11; byte >= 4; --byte) {
+      addr = addr << 8 | record[byte];
+    }
+    if (type <= 3 && fits(addr, size)) {
+      time_ = accesses_++;
+      split(addr, size, visit);
+    }
+  }
+  return n * drmemtrace_record_size;
+}
+
+// Returns whether an access of size bytes can be split in lines: it is not
+// bigger than max_access_size and its last line fits in a non-negative
+// address.
+inline bool trace_reader::fits(const std::uint64_t& addr,
+                               const std::uint64_t& size) const noexcept {
+  auto extent{size ? size - 1 : 0};
+
+  return size <= max_access_size && addr <= ~std::uint64_t{0} - extent &&
+         (addr + extent) >> line_bits_ <=
+             static_cast<std::uint64_t>(std::numeric_limits<address>::max());
+}
+
+// Passes the address of every line touched by an access of size bytes.
+// Empty accesses touch a single byte.
+template <typename Visitor>
+void trace_reader::split(const std::uint64_t& addr,
+                         const std::uint64_t& size, Visitor& visit) {
+  auto line{addr >> line_bits_};
+  auto last{(addr + (size ? size - 1 : 0)) >> line_bits_};
+
+  for (; line <= last; ++line) {
+    visit(static_cast<address>(line));
+  }
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_TRACE_READER_H_
@@ -15,11 +15,43 @@ constexpr const char* test_generator_version =
 // cachesim --help output.
 constexpr const char* cachesim_help =
     "Usage: cachesim -c=[FILENAME] -d=[FILENAME] -o=[FILENAME] -[OPTION]\n"
+    "   or: cachesim -t=[FILENAME] -o=[FILENAME] -[OPTION]\n"
+    "   or: cachesim --serve=[SOCKET]\n"
     "\t-c=[FILENAME]\t\tfilename for config file.\n"
-    "\t-d=[FILENAME]\t\tfilename for data file.\n"
+    "\t-d=[FILENAME]\t\tfilename for data file. Repeat it to share a "
+    "set-associative cache between several data files.\n"
+    "\t-f=[FORMAT]\t\tdata file format: text (default), lackey or "
+    "drmemtrace.\n"
     "\t-o=[FILENAME]\t\tfilename for output file (default value is "
     "std::cout).\n"
     "\t-x\t\toutput hex values of directions.\n"
+    "\t-l=[FILENAME]\t\tfilename for event log, written instead of the "
+    "allocation table.\n"
+    "\t-b\t\twrite the event log in binary format (default is CSV).\n"
+    "\t-t=[FILENAME]\t\toutput the allocation table of a binary event "
+    "log.\n"
+    "\t-w=[VALUE]\t\tcount hits, misses, evictions and unique addresses "
+    "every VALUE allocations.\n"
+    "\t-s=[FILENAME]\t\tfilename for the windowed statistics CSV (default "
+    "value is the output file).\n"
+    "\t-p=[VALUE]\t\tdetect phases where the hit rate changes by more than "
+    "VALUE percent points.\n"
+    "\t-a=[VALUE]\t\treport the VALUE blocks, sets and block pairs "
+    "causing most misses.\n"
+    "\t-r=[VALUES]\t\tcomma separated accesses per turn of every data "
+    "file (default value is 1).\n"
+    "\t-m=[MASKS]\t\tcomma separated hex masks of the ways every data file "
+    "may fill.\n"
+    "\t-i=[MODE]\t\tinterleave data files by weights (default) or "
+    "timestamps.\n"
+    "\t-V=[VALUE]\t\tprobe a victim cache of VALUE lines on the misses of "
+    "a direct-mapped cache.\n"
+    "\t-M=[VALUE]\t\tprobe a miss cache of VALUE lines on the misses of a "
+    "direct-mapped cache.\n"
+    "\t-T=[FILENAME]\t\tfilename for TLB config file, translating every "
+    "address before the cache.\n"
+    "\t--serve[=SOCKET]\tserve simulations on a Unix socket (default "
+    "/tmp/cachesim.sock).\n"
     "\t-h, --help\t\tdisplay all available commands.\n"
     "\t-v, --version\t\tdisplay version of test_generator.\n"
     "Full documentation at: <https://github.com/juanyaguaro/cachesim>.\n"
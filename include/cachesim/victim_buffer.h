@@ -0,0 +1,128 @@
+// Copyright 2021 Juan Yaguaro
+#ifndef CACHESIM_VICTIM_BUFFER_H_
+#define CACHESIM_VICTIM_BUFFER_H_
+
+#include <cachesim/cache_.h>
+#include <cachesim/tag_search.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cachesim {
+
+// Max number of lines of a victim buffer.
+constexpr const std::size_t max_buffer_lines = 64;
+
+// enum buffer_mode
+// Defines what a victim buffer receives.
+enum buffer_mode { VICTIM, MISS };
+
+// class victim_buffer
+// Represents a small fully-associative buffer probed on the misses of a
+// direct-mapped cache, as described by Jouppi:
+// A victim cache receives the lines evicted from the cache. A line found in
+// it is swapped with the line the cache evicts to hold it.
+// A miss cache receives a copy of every missing line. A line found in it is
+// copied into the cache and kept.
+// Lines are full addresses ordered from least to most recently used, and the
+// least recently used one is replaced. They are searched with the vectorized
+// tag kernels, so a probe costs a few compares even for the largest buffers.
+class victim_buffer {
+ public:
+  // ctor
+  victim_buffer();
+  explicit victim_buffer(const std::size_t& lines, const buffer_mode& mode);
+  // accessors
+  std::size_t size() const noexcept;
+  buffer_mode mode() const noexcept;
+  std::uint64_t hit_count() const noexcept;
+  // mutators
+  bool probe(const address& value, const address& evicted);
+  void clear() noexcept;
+
+ private:
+  void insert(const address& value) noexcept;
+  // member variables
+  std::vector<address> lines_;  // held lines, least recently used first
+  std::size_t count_;           // number of held lines
+  buffer_mode mode_;            // lines received
+  std::uint64_t hits_;          // misses of the cache found in the buffer
+};
+
+// Default ctor
+// Creates a buffer without lines, which never holds anything.
+inline victim_buffer::victim_buffer() : victim_buffer(0, VICTIM) {}
+
+// Explicit ctor
+// Creates an empty buffer of up to max_buffer_lines lines.
+inline victim_buffer::victim_buffer(const std::size_t& lines,
+                                    const buffer_mode& mode)
+    : lines_(std::min(lines, max_buffer_lines), empty_space),
+      count_(0),
+      mode_(mode),
+      hits_(0) {}
+
+// Returns the max number of lines held.
+inline std::size_t victim_buffer::size() const noexcept {
+  return lines_.size();
+}
+
+// Returns what the buffer receives.
+inline buffer_mode victim_buffer::mode() const noexcept { return mode_; }
+
+// Returns the amount of misses of the cache found in the buffer.
+inline std::uint64_t victim_buffer::hit_count() const noexcept {
+  return hits_;
+}
+
+// Looks up a line missing in the cache, given the line the cache evicts to
+// hold it (or an empty space). The buffer is updated as its mode requires.
+// Returns whether the line was found, recovering the miss.
+inline bool victim_buffer::probe(const address& value,
+                                 const address& evicted) {
+  auto i{simd::find_tag(lines_.data(), count_, value)};
+  auto found{i != count_};
+
+  if (found) {
+    std::rotate(lines_.begin() + i, lines_.begin() + i + 1,
+                lines_.begin() + count_);
+    ++hits_;
+    if (mode_ == VICTIM) {
+      --count_;
+    }
+  }
+  if (mode_ == VICTIM) {
+    if (evicted != empty_space) {
+      insert(evicted);
+    }
+  } else if (!found) {
+    insert(value);
+  }
+
+  return found;
+}
+
+// Empties the buffer and zeroes its counter.
+inline void victim_buffer::clear() noexcept {
+  count_ = 0;
+  hits_ = 0;
+}
+
+// Puts a line as the most recently used one, replacing the least recently
+// used line if the buffer is full.
+inline void victim_buffer::insert(const address& value) noexcept {
+  if (lines_.empty()) {
+    return;
+  }
+  if (count_ == lines_.size()) {
+    std::rotate(lines_.begin(), lines_.begin() + 1, lines_.end());
+    --count_;
+  }
+  lines_[count_++] = value;
+}
+
+}  // namespace cachesim
+
+#endif  // CACHESIM_VICTIM_BUFFER_H_
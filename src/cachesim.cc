@@ -4,30 +4,99 @@
 #include <cachesim/prefix.h>
 #include <cachesim/version.h>
 
+#include <cachesim/conflict_stats.h>
+#include <cachesim/event_log.h>
+#include <cachesim/interval_stats.h>
+#include <cachesim/server.h>
+#include <cachesim/shared_cache.h>
+#include <cachesim/tlb.h>
+#include <cachesim/trace_reader.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+// struct options
+// Options read from the command line.
+struct options {
+  std::string config_filename;  // -c
+  std::string output_filename;  // -o
+  std::string log_filename;     // -l
+  std::string table_filename;   // -t
+  std::string stats_filename;   // -s
+  std::string tlb_filename;     // -T
+  std::size_t window = 0;       // -w, 0 when there are no windowed stats
+  double threshold = 0;         // -p, 0 when phases are not detected
+  std::size_t conflicts = 0;    // -a, 0 when conflicts are not analyzed
+  bool hex_output = false;      // -x
+  bool binary_log = false;      // -b
+  cachesim::trace_format format = cachesim::TEXT;  // -f, data file format
+  std::vector<std::string> data_filenames;  // -d, one per tenant
+  std::vector<std::size_t> weights;         // -r, accesses per turn
+  std::vector<cachesim::way_mask> masks;    // -m, ways of every tenant
+  bool by_timestamp = false;                // -i, interleave by timestamps
+  bool tenant_options = false;              // -r, -m or -i given
+  std::size_t buffer_lines = 0;             // -V or -M, 0 without buffer
+  cachesim::buffer_mode buffer = cachesim::VICTIM;  // -V victim, -M miss
+};
+
+// struct cache_config
+// Values read from the config file.
+struct cache_config {
+  int size = 0;
+  int type = 0;
+  int line_size = 0;
+  int policy = 0;
+  int index = cachesim::MODULO;
+};
+
 // Forward declarations
 static void one_argument(const std::string& arg);
 static void many_arguments(const std::vector<std::string>& args);
-static void get_option(const std::string& arg, std::string* config,
-                       std::string* data, std::string* out, bool* hex);
-static void simulate_allocation(const std::string& config_filename,
-                                const std::string& data_filename,
-                                const std::string& output_filename,
-                                const bool& hex_output);
+static void get_option(const std::string& arg, options* opts);
+static void serve(const std::string& arg);
+static void simulate_allocation(const options& opts);
+static void simulate_shared(const options& opts);
+template <typename Allocate>
+static void simulate(std::ostream& os, const options& opts,
+                     cachesim::cache* simulator, Allocate allocate);
+static void print_log_table(const options& opts);
+static bool read_config(std::ifstream& is, cache_config* config);
 static std::unique_ptr<cachesim::cache> create_simulator(std::ifstream& is,
                                                          std::ostream& os,
                                                          const bool& hex);
+static std::unique_ptr<cachesim::shared_cache> create_shared(
+    std::ifstream& is, std::ostream& os, const options& opts);
+static std::unique_ptr<cachesim::tlb> create_tlb(std::ifstream& is);
 static void allocate_data(std::ifstream& is,
-                          std::unique_ptr<cachesim::cache>& caches);
+                          const cachesim::trace_format& format,
+                          std::unique_ptr<cachesim::cache>& caches,
+                          cachesim::tlb* translations);
+static void allocate_shared(std::vector<cachesim::trace_reader>* readers,
+                            const options& opts,
+                            cachesim::shared_cache* cache);
 static void print_header(std::ostream& os);
-static void print_footer(std::ostream& os,
-                         const std::unique_ptr<cachesim::cache>& caches);
+static void print_footer(std::ostream& os, const std::uint64_t& hits,
+                         const std::uint64_t& misses);
+static void print_tenants(std::ostream& os, const options& opts,
+                          const cachesim::shared_cache& cache);
+static void print_tlb(std::ostream& os, const cachesim::tlb& translations,
+                      const std::uint64_t& misses);
+static void print_buffer(std::ostream& os,
+                         const cachesim::victim_buffer& buffer,
+                         const std::uint64_t& misses);
+static void print_intervals(std::ostream& os, std::ostream& csv_os,
+                            const options& opts,
+                            const cachesim::interval_stats& stats);
+static void print_conflicts(std::ostream& os, const options& opts,
+                            const cachesim::conflict_stats& conflicts);
 
 // Main function
 int main(int argc, char* argv[]) {
@@ -35,16 +104,14 @@ int main(int argc, char* argv[]) {
 
   args.erase(args.begin());
   switch (args.size()) {
+    case 0:
+      std::cout << cachesim::cachesim_default;
+      break;
     case 1:
       one_argument(args[0]);
       break;
-    case 2:
-    case 3:
-    case 4:
-      many_arguments(args);
-      break;
     default:
-      std::cout << cachesim::cachesim_default;
+      many_arguments(args);
       break;
   }
 
@@ -52,42 +119,51 @@ int main(int argc, char* argv[]) {
 }
 
 // Evaluates an argument looking for the prefix of version or help.
-// It will output the help, version or default message depending on the argument
-// prefix.
+// It will output the help or version message depending on the argument prefix.
+// Any other argument is evaluated as a program option.
 static void one_argument(const std::string& arg) {
-  auto output_message = cachesim::is_version_prefix(arg)
-                            ? cachesim::cachesim_version
-                            : cachesim::is_help_prefix(arg)
-                                  ? cachesim::cachesim_help
-                                  : cachesim::error::invalid_argument;
-
-  std::cout << output_message;
+  if (cachesim::is_version_prefix(arg)) {
+    std::cout << cachesim::cachesim_version;
+  } else if (cachesim::is_help_prefix(arg)) {
+    std::cout << cachesim::cachesim_help;
+  } else if (cachesim::is_serve_prefix(arg)) {
+    serve(arg);
+  } else {
+    many_arguments({arg});
+  }
 }
 
 // Evaluates a vector of arguments to get the options inside them.
-// It aslo generates the random number files depending if the given arguments
-// were valid. Else, it will output the default message to std::cout.
+// It aslo runs the simulation (or prints a binary event log) depending if the
+// given arguments were valid. Else, it will output the default message to
+// std::cout.
+// The options of the tenants of a shared cache need several data files, and
+// the options of the windowed statistics need a window.
 static void many_arguments(const std::vector<std::string>& args) {
   auto invalid_argument_read = false;
-  auto hex_output = false;
-  std::string config_filename;
-  std::string data_filename;
-  std::string output_filename;
+  options opts;
 
   for (const auto& arg : args) {
     try {
-      get_option(arg, &config_filename, &data_filename, &output_filename,
-                 &hex_output);
+      get_option(arg, &opts);
     } catch (const std::exception& e) {
       invalid_argument_read = true;
-      config_filename.clear();
+      opts = options();
       break;
     }
   }
 
-  if (!config_filename.empty() && !data_filename.empty()) {
-    simulate_allocation(config_filename, data_filename, output_filename,
-                        hex_output);
+  if (!opts.table_filename.empty()) {
+    print_log_table(opts);
+  } else if (opts.tenant_options && opts.data_filenames.size() < 2) {
+    std::cout << cachesim::error::invalid_tenant_options;
+  } else if ((opts.threshold != 0 || !opts.stats_filename.empty()) &&
+             !opts.window) {
+    std::cout << cachesim::error::invalid_window_options;
+  } else if (!opts.config_filename.empty() && opts.data_filenames.size() > 1) {
+    simulate_shared(opts);
+  } else if (!opts.config_filename.empty() && !opts.data_filenames.empty()) {
+    simulate_allocation(opts);
   } else {
     std::cout << (invalid_argument_read
                       ? cachesim::error::invalid_argument
@@ -97,89 +173,354 @@ static void many_arguments(const std::vector<std::string>& args) {
 
 // Overwrites the pointer of the selected prefix.
 // In case no prefix was found, it won't do anything (No option was found).
-static void get_option(const std::string& arg, std::string* config,
-                       std::string* data, std::string* out, bool* hex) {
-  if (arg.size() > 4) {
+static void get_option(const std::string& arg, options* opts) {
+  if (arg.size() > 3) {
     if (arg.rfind(cachesim::config_prefix, 0) == 0) {
-      *config = arg.substr(3);
+      opts->config_filename = arg.substr(3);
     } else if (arg.rfind(cachesim::data_prefix, 0) == 0) {
-      *data = arg.substr(3);
+      opts->data_filenames.push_back(arg.substr(3));
     } else if (arg.rfind(cachesim::out_prefix, 0) == 0) {
-      *out = arg.substr(3);
+      opts->output_filename = arg.substr(3);
+    } else if (arg.rfind(cachesim::log_prefix, 0) == 0) {
+      opts->log_filename = arg.substr(3);
+    } else if (arg.rfind(cachesim::table_prefix, 0) == 0) {
+      opts->table_filename = arg.substr(3);
+    } else if (arg.rfind(cachesim::stats_prefix, 0) == 0) {
+      opts->stats_filename = arg.substr(3);
+    } else if (arg.rfind(cachesim::tlb_prefix, 0) == 0) {
+      opts->tlb_filename = arg.substr(3);
+    } else if (arg.rfind(cachesim::victim_prefix, 0) == 0 ||
+               arg.rfind(cachesim::miss_cache_prefix, 0) == 0) {
+      if (opts->buffer_lines) {
+        throw std::invalid_argument(cachesim::error::invalid_argument);
+      }
+      opts->buffer_lines = std::stoul(arg.substr(3));
+      opts->buffer = arg.rfind(cachesim::victim_prefix, 0) == 0
+                         ? cachesim::VICTIM
+                         : cachesim::MISS;
+      if (!opts->buffer_lines ||
+          opts->buffer_lines > cachesim::max_buffer_lines) {
+        throw std::invalid_argument(cachesim::error::invalid_argument);
+      }
+    } else if (arg.rfind(cachesim::window_prefix, 0) == 0) {
+      opts->window = std::stoul(arg.substr(3));
+      if (!opts->window || opts->window > cachesim::max_window) {
+        throw std::invalid_argument(cachesim::error::invalid_argument);
+      }
+    } else if (arg.rfind(cachesim::phase_prefix, 0) == 0) {
+      opts->threshold = std::stod(arg.substr(3)) / 100;
+    } else if (arg.rfind(cachesim::conflict_prefix, 0) == 0) {
+      opts->conflicts = std::stoul(arg.substr(3));
+      if (!opts->conflicts || opts->conflicts > cachesim::max_conflicts) {
+        throw std::invalid_argument(cachesim::error::invalid_argument);
+      }
+    } else if (arg.rfind(cachesim::format_prefix, 0) == 0) {
+      if (!cachesim::parse_trace_format(arg.substr(3), &opts->format)) {
+        throw std::invalid_argument(cachesim::error::invalid_argument);
+      }
+    } else if (arg.rfind(cachesim::weight_prefix, 0) == 0) {
+      opts->tenant_options = true;
+      std::istringstream values(arg.substr(3));
+      for (std::string value; std::getline(values, value, ',');) {
+        opts->weights.push_back(std::stoul(value));
+        if (!opts->weights.back()) {
+          throw std::invalid_argument(cachesim::error::invalid_argument);
+        }
+      }
+    } else if (arg.rfind(cachesim::mask_prefix, 0) == 0) {
+      opts->tenant_options = true;
+      std::istringstream values(arg.substr(3));
+      for (std::string value; std::getline(values, value, ',');) {
+        opts->masks.emplace_back();
+        if (!cachesim::parse_way_mask(value, &opts->masks.back())) {
+          throw std::invalid_argument(cachesim::error::invalid_argument);
+        }
+      }
+    } else if (arg.rfind(cachesim::interleave_prefix, 0) == 0) {
+      opts->tenant_options = true;
+      if (arg.substr(3) == cachesim::interleave_timestamps) {
+        opts->by_timestamp = true;
+      } else if (arg.substr(3) != cachesim::interleave_weights) {
+        throw std::invalid_argument(cachesim::error::invalid_argument);
+      }
     } else {
       throw std::invalid_argument(cachesim::error::invalid_argument);
     }
   } else if (arg == cachesim::hex_prefix) {
-    *hex = true;
+    opts->hex_output = true;
+  } else if (arg == cachesim::binary_prefix) {
+    opts->binary_log = true;
   } else {
     throw std::invalid_argument(cachesim::error::invalid_argument);
   }
 }
 
+// Runs the simulation server on the socket given after the server prefix, or
+// on the default socket, with a thread per hardware thread.
+static void serve(const std::string& arg) {
+  std::string path(arg.size() > cachesim::serve_prefix.size()
+                       ? arg.substr(cachesim::serve_prefix.size() + 1)
+                       : cachesim::serve_default_path);
+  cachesim::server simulation_server(path,
+                                     std::thread::hardware_concurrency());
+
+  if (!simulation_server.run()) {
+    std::cout << cachesim::error::failed_to_serve << path << '\n';
+  }
+}
+
 // Simulates the allocation of the addresses obtained in the  data file,
 // configuring the cache depending on the parameters extracted from config file.
+// When a TLB config file is given, every address is translated first and the
+// TLB totals are output after the cache totals.
+// Tags are sized for the addresses of the data file format, or for 64-bit
+// addresses when translating, since page walks read above the 48-bit virtual
+// addresses.
+// When a victim or miss cache is requested, the misses it recovers are output
+// after the cache totals. It needs a direct-mapped cache.
 // It will redirect program output to the std::ostream specified.
-static void simulate_allocation(const std::string& config_filename,
-                                const std::string& data_filename,
-                                const std::string& output_filename,
-                                const bool& hex_output) {
-  std::ifstream config_is(config_filename);
-  std::ifstream data_is(data_filename);
-  std::ofstream ofs(output_filename, std::ios::out);
-  std::ostream& os = output_filename.empty() ? std::cout : ofs;
+static void simulate_allocation(const options& opts) {
+  std::ifstream config_is(opts.config_filename);
+  std::ifstream data_is(opts.data_filenames[0],
+                        std::ios::in | std::ios::binary);
+  std::ofstream ofs(opts.output_filename, std::ios::out);
+  std::ostream& os = opts.output_filename.empty() ? std::cout : ofs;
+  std::unique_ptr<cachesim::tlb> translations = nullptr;
 
+  if (!opts.output_filename.empty() && !ofs.is_open()) {
+    std::cout << cachesim::error::failed_to_open << opts.output_filename
+              << '\n';
+    return;
+  }
+  if (!opts.tlb_filename.empty()) {
+    std::ifstream tlb_is(opts.tlb_filename);
+    if (!tlb_is.is_open()) {
+      std::cout << cachesim::error::failed_to_open << opts.tlb_filename
+                << '\n';
+      return;
+    }
+    translations = create_tlb(tlb_is);
+    if (!translations) {
+      std::cout << cachesim::error::invalid_tlb_config;
+      return;
+    }
+  }
   if (config_is.is_open()) {
     std::unique_ptr<cachesim::cache> cache_simulator(
-        create_simulator(config_is, os, hex_output));
-    if (data_is.is_open()) {
+        create_simulator(config_is, os, opts.hex_output));
+    auto direct{dynamic_cast<cachesim::direct_cache*>(cache_simulator.get())};
+    if (cache_simulator && opts.buffer_lines && !direct) {
+      std::cout << cachesim::error::invalid_buffer_cache_type;
+    } else if (data_is.is_open()) {
       if (cache_simulator) {
-        print_header(os);
-        allocate_data(data_is, cache_simulator);
-        print_footer(os, cache_simulator);
+        cache_simulator->set_address_bits(
+            translations
+                ? cachesim::line_address_bits(cache_simulator->line_size())
+                : cachesim::address_bits(opts.format,
+                                         cache_simulator->line_size()));
+        if (opts.buffer_lines) {
+          direct->set_buffer(opts.buffer_lines, opts.buffer);
+        }
+        simulate(os, opts, cache_simulator.get(), [&]() {
+          allocate_data(data_is, opts.format, cache_simulator,
+                        translations.get());
+        });
+        if (opts.buffer_lines) {
+          print_buffer(os, direct->buffer(), cache_simulator->miss_count());
+        }
+        if (translations) {
+          print_tlb(os, *translations, cache_simulator->miss_count());
+        }
       } else {
         std::cout << cachesim::error::invalid_cache_size;
       }
     } else {
-      std::cout << cachesim::error::failed_to_open << data_filename << '\n';
+      std::cout << cachesim::error::failed_to_open << opts.data_filenames[0]
+                << '\n';
     }
   } else {
-    std::cout << cachesim::error::failed_to_open << config_filename << '\n';
+    std::cout << cachesim::error::failed_to_open << opts.config_filename
+              << '\n';
   }
 }
 
+// Simulates several data files sharing a set-associative cache, one tenant
+// per data file, interleaved in a single pass. The totals of every tenant are
+// output after the totals of the cache.
+static void simulate_shared(const options& opts) {
+  std::ifstream config_is(opts.config_filename);
+  std::vector<std::ifstream> data_is;
+  std::ofstream ofs(opts.output_filename, std::ios::out);
+  std::ostream& os = opts.output_filename.empty() ? std::cout : ofs;
+
+  if (!config_is.is_open()) {
+    std::cout << cachesim::error::failed_to_open << opts.config_filename
+              << '\n';
+    return;
+  }
+  if (!opts.output_filename.empty() && !ofs.is_open()) {
+    std::cout << cachesim::error::failed_to_open << opts.output_filename
+              << '\n';
+    return;
+  }
+  if (!opts.tlb_filename.empty()) {
+    std::cout << cachesim::error::invalid_shared_tlb;
+    return;
+  }
+  if (opts.buffer_lines) {
+    std::cout << cachesim::error::invalid_buffer_cache_type;
+    return;
+  }
+  auto cache_simulator{create_shared(config_is, os, opts)};
+  if (!cache_simulator) {
+    return;
+  }
+  for (const auto& filename : opts.data_filenames) {
+    data_is.emplace_back(filename, std::ios::in | std::ios::binary);
+    if (!data_is.back().is_open()) {
+      std::cout << cachesim::error::failed_to_open << filename << '\n';
+      return;
+    }
+  }
+
+  std::vector<cachesim::trace_reader> readers;
+  readers.reserve(data_is.size());
+  for (auto& is : data_is) {
+    readers.emplace_back(is, opts.format, cache_simulator->line_size(),
+                         opts.by_timestamp);
+  }
+  simulate(os, opts, cache_simulator.get(), [&]() {
+    allocate_shared(&readers, opts, cache_simulator.get());
+  });
+  print_tenants(os, opts, *cache_simulator);
+}
+
+// Runs allocate on the simulator, printing the allocation table and the
+// totals.
+// When an event log is requested, the allocation table is written to the log
+// instead, and only the totals are output. Nothing is simulated if the log
+// can't be opened.
+// When a conflict analysis is requested, it is output after the totals.
+// When windowed statistics are requested, they are output after the totals,
+// or to the stats file. Nothing is simulated if the stats file can't be
+// opened.
+template <typename Allocate>
+static void simulate(std::ostream& os, const options& opts,
+                     cachesim::cache* simulator, Allocate allocate) {
+  std::unique_ptr<cachesim::interval_stats> stats = nullptr;
+  std::unique_ptr<cachesim::conflict_stats> conflicts = nullptr;
+  std::ofstream log_os;
+  std::ofstream stats_os;
+
+  if (!opts.log_filename.empty()) {
+    log_os.open(opts.log_filename, std::ios::out | std::ios::binary);
+    if (!log_os.is_open()) {
+      std::cout << cachesim::error::failed_to_open << opts.log_filename
+                << '\n';
+      return;
+    }
+  }
+  if (!opts.stats_filename.empty()) {
+    stats_os.open(opts.stats_filename, std::ios::out);
+    if (!stats_os.is_open()) {
+      std::cout << cachesim::error::failed_to_open << opts.stats_filename
+                << '\n';
+      return;
+    }
+  }
+  if (opts.window) {
+    stats = std::make_unique<cachesim::interval_stats>(opts.window,
+                                                       opts.threshold);
+    simulator->attach_stats(stats.get());
+  }
+  if (opts.conflicts) {
+    conflicts = std::make_unique<cachesim::conflict_stats>(opts.conflicts);
+    simulator->attach_conflicts(conflicts.get());
+  }
+  if (opts.log_filename.empty()) {
+    print_header(os);
+    allocate();
+  } else {
+    cachesim::event_log log(log_os,
+                            opts.binary_log ? cachesim::BINARY : cachesim::CSV);
+    simulator->attach_log(&log);
+    allocate();
+    simulator->attach_log(nullptr);
+  }
+  print_footer(os, simulator->hit_count(), simulator->miss_count());
+  if (conflicts) {
+    simulator->attach_conflicts(nullptr);
+    print_conflicts(os, opts, *conflicts);
+  }
+  if (stats) {
+    simulator->attach_stats(nullptr);
+    stats->finish();
+    print_intervals(os, opts.stats_filename.empty() ? os : stats_os, opts,
+                    *stats);
+  }
+}
+
+// Outputs the allocation table stored in a binary event log, followed by the
+// totals of the logged allocations.
+static void print_log_table(const options& opts) {
+  std::ifstream log_is(opts.table_filename, std::ios::in | std::ios::binary);
+  std::ofstream ofs(opts.output_filename, std::ios::out);
+  std::ostream& os = opts.output_filename.empty() ? std::cout : ofs;
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+
+  if (!opts.output_filename.empty() && !ofs.is_open()) {
+    std::cout << cachesim::error::failed_to_open << opts.output_filename
+              << '\n';
+  } else if (log_is.is_open()) {
+    if (cachesim::read_event_log_header(log_is)) {
+      print_header(os);
+      cachesim::print_event_log(
+          log_is, os, opts.hex_output,
+          [&](const cachesim::event& e) { ++(e.hit ? hits : misses); });
+      print_footer(os, hits, misses);
+    } else {
+      std::cout << cachesim::error::invalid_event_log;
+    }
+  } else {
+    std::cout << cachesim::error::failed_to_open << opts.table_filename
+              << '\n';
+  }
+}
+
+// Reads the config input file.
+// The index policy is optional, addresses are mapped with modulo if it is not
+// present. Returns false if no valid data was read.
+static bool read_config(std::ifstream& is, cache_config* config) {
+  if (is >> config->size >> config->type >> config->line_size >>
+      config->policy) {
+    if (!(is >> config->index)) {
+      config->index = cachesim::MODULO;
+    }
+    return true;
+  }
+  return false;
+}
+
 // Returns a cachesim::cache instance depending on the config input file.
 // It will check for the data beforehand, making sure that no invalid data was
 // read.
 static std::unique_ptr<cachesim::cache> create_simulator(std::ifstream& is,
                                                          std::ostream& os,
                                                          const bool& hex) {
-  int size = 0;
-  int type = 0;
-  int line_size = 0;
-  int policy = 0;
+  cache_config config;
   std::unique_ptr<cachesim::cache> new_cache = nullptr;
 
-  if (is >> size >> type >> line_size >> policy) {
-    switch (type) {
-      case 0:
-        try {
-          new_cache = std::make_unique<cachesim::direct_cache>(size, line_size,
-                                                               policy, os, hex);
-        } catch (const std::exception& e) {
-          new_cache = nullptr;
-        }
-        break;
-      case 1:
-        try {
-          new_cache = std::make_unique<cachesim::set_associative_cache>(
-              size, line_size, policy, os, hex);
-        } catch (const std::exception& e) {
-          new_cache = nullptr;
-        }
-        break;
-      default:
+  if (read_config(is, &config)) {
+    try {
+      new_cache = cachesim::make_cache(config.size, config.type,
+                                       config.line_size, config.policy,
+                                       config.index, os, hex);
+      if (!new_cache) {
         std::cout << cachesim::error::invalid_cache_type;
-        break;
+      }
+    } catch (const std::exception& e) {
+      new_cache = nullptr;
     }
   } else {
     std::cout << cachesim::error::invalid_config_input;
@@ -188,12 +529,147 @@ static std::unique_ptr<cachesim::cache> create_simulator(std::ifstream& is,
   return new_cache;
 }
 
-// Allocates the data read from the data file into the cache simulator.
+// Returns a cachesim::shared_cache instance, with a tenant per data file,
+// depending on the config input file and the way masks. The config file must
+// describe a set-associative cache.
+// Returns nullptr, after printing the error, if the cache is not valid.
+static std::unique_ptr<cachesim::shared_cache> create_shared(
+    std::ifstream& is, std::ostream& os, const options& opts) {
+  cache_config config;
+  std::unique_ptr<cachesim::shared_cache> new_cache = nullptr;
+
+  if (!read_config(is, &config)) {
+    std::cout << cachesim::error::invalid_config_input;
+  } else if (config.type != cachesim::SET_ASSOCIATIVE ||
+             opts.data_filenames.size() > cachesim::max_tenants) {
+    std::cout << cachesim::error::invalid_shared_cache_type;
+  } else if (config.policy < cachesim::LRU || config.policy > cachesim::MRU ||
+             config.index < cachesim::MODULO ||
+             config.index > cachesim::PRIME_MODULO) {
+    std::cout << cachesim::error::invalid_cache_type;
+  } else {
+    try {
+      new_cache = std::make_unique<cachesim::shared_cache>(
+          config.size, config.line_size, config.policy, os, opts.hex_output,
+          config.index, opts.data_filenames.size());
+      new_cache->set_address_bits(
+          cachesim::address_bits(opts.format, config.line_size));
+    } catch (const std::exception& e) {
+      std::cout << cachesim::error::invalid_cache_size;
+      return nullptr;
+    }
+    for (std::size_t i = 0; i < opts.masks.size() && new_cache; ++i) {
+      if (i < opts.data_filenames.size() &&
+          !new_cache->set_way_mask(i, opts.masks[i])) {
+        std::cout << cachesim::error::invalid_way_mask;
+        new_cache = nullptr;
+      }
+    }
+  }
+
+  return new_cache;
+}
+
+// Returns a cachesim::tlb instance depending on the TLB config input file:
+// the page size in bytes, the emplace policy and the entries and ways of every
+// level, first level first.
+// Returns nullptr if no valid data was read, or if the entries of a level are
+// not followed by its ways.
+static std::unique_ptr<cachesim::tlb> create_tlb(std::ifstream& is) {
+  std::size_t page_size = 0;
+  int policy = 0;
+  std::size_t entries = 0;
+  std::size_t ways = 0;
+  std::unique_ptr<cachesim::tlb> new_tlb = nullptr;
+
+  if (is >> page_size >> policy) {
+    try {
+      new_tlb = std::make_unique<cachesim::tlb>(page_size, policy);
+    } catch (const std::exception& e) {
+      return nullptr;
+    }
+    while (is >> entries) {
+      if (!(is >> ways) || !new_tlb->add_level(entries, ways)) {
+        return nullptr;
+      }
+    }
+    if (!is.eof() || !new_tlb->level_count()) {
+      new_tlb = nullptr;
+    }
+  }
+
+  return new_tlb;
+}
+
+// Allocates the data read from the data file into the cache simulator, as it
+// is streamed from the file.
+// Addresses are line addresses. With a TLB, the byte address of every line is
+// translated first, and the page table entries read by its page walk, if any,
+// are allocated before it.
 static void allocate_data(std::ifstream& is,
-                          std::unique_ptr<cachesim::cache>& caches) {
-  int dir = 0;
-  while (is >> dir) {
+                          const cachesim::trace_format& format,
+                          std::unique_ptr<cachesim::cache>& caches,
+                          cachesim::tlb* translations) {
+  cachesim::trace_reader reader(is, format, caches->line_size());
+  auto line_size{static_cast<std::uint64_t>(caches->line_size())};
+
+  reader.read([&](const cachesim::address& dir) {
+    if (translations) {
+      translations->translate(static_cast<std::uint64_t>(dir) * line_size,
+                              [&](const std::uint64_t& entry) {
+                                return caches->allocate(
+                                    static_cast<cachesim::address>(
+                                        entry / line_size));
+                              });
+    }
     caches->allocate(dir);
+  });
+}
+
+// Allocates the data of every tenant into the shared cache, pulling the
+// addresses from all the data files in a single pass.
+// By default tenants take turns, allocating as many addresses as their weight
+// (1 if not given) every turn. By timestamp, the address with the lowest
+// timestamp among all data files goes first, the first tenant on ties.
+static void allocate_shared(std::vector<cachesim::trace_reader>* readers,
+                            const options& opts,
+                            cachesim::shared_cache* cache) {
+  auto n{readers->size()};
+  std::vector<cachesim::address> values(n);
+  std::vector<std::uint64_t> times(n);
+  std::vector<bool> pending(n);
+
+  for (std::size_t i = 0; i < n; ++i) {
+    pending[i] = (*readers)[i].next(&values[i], &times[i]);
+  }
+  if (opts.by_timestamp) {
+    for (;;) {
+      auto first{n};
+      for (std::size_t i = 0; i < n; ++i) {
+        if (pending[i] && (first == n || times[i] < times[first])) {
+          first = i;
+        }
+      }
+      if (first == n) {
+        break;
+      }
+      cache->set_tenant(first);
+      cache->allocate(values[first]);
+      pending[first] = (*readers)[first].next(&values[first], &times[first]);
+    }
+  } else {
+    auto active{std::count(pending.begin(), pending.end(), true)};
+    while (active) {
+      for (std::size_t i = 0; i < n; ++i) {
+        auto turn{i < opts.weights.size() ? opts.weights[i] : 1};
+        cache->set_tenant(i);
+        for (; turn && pending[i]; --turn) {
+          cache->allocate(values[i]);
+          pending[i] = (*readers)[i].next(&values[i], &times[i]);
+          active -= !pending[i];
+        }
+      }
+    }
   }
 }
 
@@ -215,12 +691,11 @@ static void print_header(std::ostream& os) {
 }
 
 // Outputs footer content to the given std::ostream.
-static void print_footer(std::ostream& os,
-                         const std::unique_ptr<cachesim::cache>& caches) {
-  double total{static_cast<double>(caches->hit_count()) +
-               static_cast<double>(caches->miss_count())};
-  double hit_freq{100 * static_cast<double>(caches->hit_count()) / total};
-  double miss_freq{100 * static_cast<double>(caches->miss_count()) / total};
+static void print_footer(std::ostream& os, const std::uint64_t& hits,
+                         const std::uint64_t& misses) {
+  double total{static_cast<double>(hits) + static_cast<double>(misses)};
+  double hit_freq{100 * static_cast<double>(hits) / total};
+  double miss_freq{100 * static_cast<double>(misses) / total};
 
   os.width(25);
   os << "Total cache allocations: ";
@@ -229,11 +704,11 @@ static void print_footer(std::ostream& os,
   os.width(25);
   os << "Total cache hits: ";
   os.width(10);
-  os << caches->hit_count() << '\n';
+  os << hits << '\n';
   os.width(25);
   os << "Total cache misses: ";
   os.width(10);
-  os << caches->miss_count() << '\n';
+  os << misses << '\n';
   os.width(25);
   os << "Cache hit frequency: ";
   os.width(10);
@@ -243,3 +718,148 @@ static void print_footer(std::ostream& os,
   os.width(10);
   os << miss_freq << "%\n";
 }
+
+// Outputs the totals of every tenant of a shared cache to the given
+// std::ostream, with the data file of the tenant.
+static void print_tenants(std::ostream& os, const options& opts,
+                          const cachesim::shared_cache& cache) {
+  os << std::setfill('-') << std::setw(106) << '\n';
+  os << std::setfill(' ') << std::setw(8) << "Tenant" << std::setw(12)
+     << "Hits" << std::setw(12) << "Misses" << std::setw(12) << "Hit freq."
+     << std::setw(12) << "Evictions" << std::setw(14) << "Interference"
+     << std::setw(10) << "Lines" << "  Data file\n";
+  os << std::setfill('-') << std::setw(106) << '\n';
+  os << std::setfill(' ');
+  for (std::size_t i = 0; i < cache.tenant_count(); ++i) {
+    const auto& tenant{cache.counters(i)};
+    auto total{static_cast<double>(tenant.hits + tenant.misses)};
+    os << std::setw(8) << i << std::setw(12) << tenant.hits << std::setw(12)
+       << tenant.misses << std::setw(11)
+       << (total ? 100 * static_cast<double>(tenant.hits) / total : 0) << '%'
+       << std::setw(12) << tenant.evictions << std::setw(14)
+       << tenant.interference << std::setw(10) << tenant.lines << "  "
+       << opts.data_filenames[i] << '\n';
+  }
+}
+
+// Outputs the misses of the cache found in the victim or miss cache to the
+// given std::ostream, as an amount and as a share of all cache misses, along
+// with the misses left for the next memory level.
+static void print_buffer(std::ostream& os,
+                         const cachesim::victim_buffer& buffer,
+                         const std::uint64_t& misses) {
+  auto recovered{buffer.hit_count()};
+
+  os.width(25);
+  os << (buffer.mode() == cachesim::VICTIM ? "Victim cache hits: "
+                                           : "Miss cache hits: ");
+  os.width(10);
+  os << recovered << '\n';
+  os.width(25);
+  os << "Recovered miss freq.: ";
+  os.width(10);
+  os << (misses ? 100 * static_cast<double>(recovered) / misses : 0) << "%\n";
+  os.width(25);
+  os << "Remaining misses: ";
+  os.width(10);
+  os << misses - recovered << '\n';
+}
+
+// Outputs the totals of every TLB level and of the page walks to the given
+// std::ostream. The cache misses of the page table entries are also output as
+// a share of all cache misses.
+static void print_tlb(std::ostream& os, const cachesim::tlb& translations,
+                      const std::uint64_t& misses) {
+  for (std::size_t i = 0; i < translations.level_count(); ++i) {
+    const auto& level{translations.counters(i)};
+    auto total{static_cast<double>(level.hits + level.misses)};
+    auto name{"TLB L" + std::to_string(i + 1)};
+    os.width(25);
+    os << name + " hits: ";
+    os.width(10);
+    os << level.hits << '\n';
+    os.width(25);
+    os << name + " misses: ";
+    os.width(10);
+    os << level.misses << '\n';
+    os.width(25);
+    os << name + " hit frequency: ";
+    os.width(10);
+    os << (total ? 100 * static_cast<double>(level.hits) / total : 0) << "%\n";
+  }
+  os.width(25);
+  os << "Page walks: ";
+  os.width(10);
+  os << translations.walk_count() << '\n';
+  os.width(25);
+  os << "Page walk accesses: ";
+  os.width(10);
+  os << translations.walk_access_count() << '\n';
+  os.width(25);
+  os << "Page walk misses: ";
+  os.width(10);
+  os << translations.walk_miss_count() << '\n';
+  os.width(25);
+  os << "Page walk miss share: ";
+  os.width(10);
+  os << (misses ? 100 * static_cast<double>(translations.walk_miss_count()) /
+                      misses
+                : 0)
+     << "%\n";
+}
+
+// Outputs the windowed statistics as CSV to csv_os, the stats file or the
+// given std::ostream. The amount of phases is output to the given
+// std::ostream as well when phases are detected.
+static void print_intervals(std::ostream& os, std::ostream& csv_os,
+                            const options& opts,
+                            const cachesim::interval_stats& stats) {
+  if (opts.threshold > 0) {
+    os.width(25);
+    os << "Phases detected: ";
+    os.width(10);
+    os << stats.phase_count() << '\n';
+  }
+  stats.write_csv(csv_os);
+}
+
+// Outputs the conflict analysis to the given std::ostream: the blocks missing
+// most often, the sets evicting most often and the pairs of blocks evicting
+// each other most often. Counts are estimates and may exceed the actual ones.
+static void print_conflicts(std::ostream& os, const options& opts,
+                            const cachesim::conflict_stats& conflicts) {
+  auto to_hex{opts.hex_output ? std::hex : std::dec};
+
+  os << std::setfill('-') << std::setw(106) << '\n';
+  os << std::setfill(' ') << std::setw(8) << "Rank" << std::setw(25)
+     << "Missing block" << std::setw(12) << "Misses" << '\n';
+  os << std::setfill('-') << std::setw(106) << '\n';
+  os << std::setfill(' ');
+  auto blocks{conflicts.missing_blocks()};
+  for (std::size_t i = 0; i < blocks.size(); ++i) {
+    os << std::setw(8) << i + 1 << to_hex << std::setw(25) << blocks[i].item
+       << std::dec << std::setw(12) << blocks[i].count << '\n';
+  }
+  os << std::setfill('-') << std::setw(106) << '\n';
+  os << std::setfill(' ') << std::setw(8) << "Rank" << std::setw(25)
+     << "Set ID" << std::setw(12) << "Evictions" << '\n';
+  os << std::setfill('-') << std::setw(106) << '\n';
+  os << std::setfill(' ');
+  auto sets{conflicts.thrashed_sets()};
+  for (std::size_t i = 0; i < sets.size(); ++i) {
+    os << std::setw(8) << i + 1 << std::setw(25) << sets[i].item
+       << std::setw(12) << sets[i].count << '\n';
+  }
+  os << std::setfill('-') << std::setw(106) << '\n';
+  os << std::setfill(' ') << std::setw(8) << "Rank" << std::setw(25)
+     << "First block" << std::setw(25) << "Second block" << std::setw(12)
+     << "Evictions" << '\n';
+  os << std::setfill('-') << std::setw(106) << '\n';
+  os << std::setfill(' ');
+  auto pairs{conflicts.evicting_pairs()};
+  for (std::size_t i = 0; i < pairs.size(); ++i) {
+    os << std::setw(8) << i + 1 << to_hex << std::setw(25)
+       << pairs[i].item.first << std::setw(25) << pairs[i].item.second
+       << std::dec << std::setw(12) << pairs[i].count << '\n';
+  }
+}
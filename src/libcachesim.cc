@@ -0,0 +1,115 @@
+// Copyright 2021 Juan Yaguaro
+#include <cachesim/cache.h>
+#include <cachesim/cachesim.h>
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+// struct cachesim_cache
+// Simulated cache behind the C interface.
+struct cachesim_cache {
+  std::unique_ptr<cachesim::cache> simulator;  // quiet simulated cache
+};
+
+// Returns the version of the C interface.
+int cachesim_api_version(void) { return CACHESIM_API_VERSION; }
+
+// Creates a quiet cache from the config, checked before anything is built.
+// No exception leaves the library: failed allocations and any other failure
+// become statuses.
+cachesim_status cachesim_create(const cachesim_config* config,
+                                cachesim_cache** cache) {
+  if (!config || !cache) {
+    return CACHESIM_INVALID_ARGUMENT;
+  }
+  if (config->type > cachesim::SKEWED_ASSOCIATIVE ||
+      config->policy > cachesim::MRU ||
+      config->index > cachesim::PRIME_MODULO ||
+      !cachesim::is_valid_size(config->size, config->line_size)) {
+    return CACHESIM_INVALID_CONFIG;
+  }
+
+  try {
+    auto created{std::make_unique<cachesim_cache>()};
+    created->simulator = cachesim::make_cache(
+        config->size, static_cast<int>(config->type), config->line_size,
+        static_cast<int>(config->policy), static_cast<int>(config->index),
+        std::cout, false);
+    if (!created->simulator) {
+      return CACHESIM_INVALID_CONFIG;
+    }
+    created->simulator->set_quiet(true);
+    *cache = created.release();
+  } catch (const std::bad_alloc& e) {
+    return CACHESIM_OUT_OF_MEMORY;
+  } catch (const std::invalid_argument& e) {
+    return CACHESIM_INVALID_CONFIG;
+  } catch (...) {
+    return CACHESIM_INTERNAL_ERROR;
+  }
+  return CACHESIM_OK;
+}
+
+// Allocates a batch of addresses straight from the caller's buffers. If an
+// allocation fails, the counters keep the allocations done before it.
+cachesim_status cachesim_simulate_batch(cachesim_cache* cache,
+                                        const uint64_t* addresses, size_t n,
+                                        uint8_t* results) {
+  if (!cache || (n && !addresses)) {
+    return CACHESIM_INVALID_ARGUMENT;
+  }
+  constexpr auto max_address{static_cast<std::uint64_t>(
+      std::numeric_limits<cachesim::address>::max())};
+  for (std::size_t i = 0; i < n; ++i) {
+    if (addresses[i] > max_address) {
+      return CACHESIM_INVALID_ARGUMENT;
+    }
+  }
+
+  auto& simulator{*cache->simulator};
+  try {
+    for (std::size_t i = 0; i < n; ++i) {
+      auto hit{
+          simulator.allocate(static_cast<cachesim::address>(addresses[i]))};
+      if (results) {
+        results[i] = hit;
+      }
+    }
+  } catch (const std::bad_alloc& e) {
+    return CACHESIM_OUT_OF_MEMORY;
+  } catch (...) {
+    return CACHESIM_INTERNAL_ERROR;
+  }
+  return CACHESIM_OK;
+}
+
+// Copies the counters of the cache.
+cachesim_status cachesim_get_counters(const cachesim_cache* cache,
+                                      cachesim_counters* counters) {
+  if (!cache || !counters) {
+    return CACHESIM_INVALID_ARGUMENT;
+  }
+  counters->hits = cache->simulator->hit_count();
+  counters->misses = cache->simulator->miss_count();
+  return CACHESIM_OK;
+}
+
+// Empties the cache and zeroes its counters.
+cachesim_status cachesim_reset(cachesim_cache* cache) {
+  if (!cache) {
+    return CACHESIM_INVALID_ARGUMENT;
+  }
+  try {
+    cache->simulator->clear();
+  } catch (...) {
+    return CACHESIM_INTERNAL_ERROR;
+  }
+  return CACHESIM_OK;
+}
+
+// Destroys the cache.
+void cachesim_destroy(cachesim_cache* cache) { delete cache; }
@@ -0,0 +1,135 @@
+// Copyright 2021 Juan Yaguaro
+// Tests of the C interface of libcachesim, linked as a static library from a
+// C program: a create, simulate, reset and destroy round trip, and the
+// configs and arguments every function must reject.
+#include <cachesim/cachesim.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(int condition, const char* what) {
+  if (!condition) {
+    printf("FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+// Returns the status of creating a cache from the given config, destroying
+// the cache if it was created.
+static cachesim_status create_status(uint64_t size, uint64_t line_size,
+                                     uint32_t type, uint32_t policy,
+                                     uint32_t index) {
+  cachesim_config config = {size, line_size, type, policy, index};
+  cachesim_cache* cache = NULL;
+  cachesim_status status = cachesim_create(&config, &cache);
+
+  cachesim_destroy(cache);
+  return status;
+}
+
+// Creates a cache, allocates addresses in it, reads its counters and resets
+// it.
+static void test_round_trip(void) {
+  cachesim_config config = {1024, 4, 1, 0, 0};
+  cachesim_cache* cache = NULL;
+  cachesim_counters counters = {0, 0};
+  const uint64_t addresses[] = {1, 2, 1, UINT64_C(1) << 40};
+  uint8_t results[4] = {9, 9, 9, 9};
+
+  check(cachesim_api_version() == CACHESIM_API_VERSION,
+        "the library has the version of the header");
+  check(cachesim_create(&config, &cache) == CACHESIM_OK && cache,
+        "a valid config creates a cache");
+  if (!cache) {
+    return;
+  }
+  check(cachesim_simulate_batch(cache, addresses, 4, results) == CACHESIM_OK,
+        "a batch is simulated");
+  check(results[0] == 0 && results[1] == 0 && results[2] == 1 &&
+            results[3] == 0,
+        "the batch answers miss, miss, hit, miss");
+  check(cachesim_simulate_batch(cache, addresses, 3, NULL) == CACHESIM_OK,
+        "a batch without results is simulated");
+  check(cachesim_get_counters(cache, &counters) == CACHESIM_OK &&
+            counters.hits == 4 && counters.misses == 3,
+        "the counters hold 4 hits and 3 misses");
+  check(cachesim_reset(cache) == CACHESIM_OK &&
+            cachesim_get_counters(cache, &counters) == CACHESIM_OK &&
+            counters.hits == 0 && counters.misses == 0,
+        "a reset zeroes the counters");
+  check(cachesim_simulate_batch(cache, addresses, 1, results) == CACHESIM_OK &&
+            results[0] == 0,
+        "a reset empties the cache");
+  cachesim_destroy(cache);
+}
+
+// Sends configs the library must reject before building anything.
+static void test_invalid_configs(void) {
+  check(create_status(64, 0, 1, 0, 0) == CACHESIM_INVALID_CONFIG,
+        "line size 0 is rejected");
+  check(create_status(0, 4, 1, 0, 0) == CACHESIM_INVALID_CONFIG,
+        "size 0 is rejected");
+  check(create_status(48, 4, 1, 0, 0) == CACHESIM_INVALID_CONFIG,
+        "a size not a power of 2 is rejected");
+  check(create_status(64, 128, 1, 0, 0) == CACHESIM_INVALID_CONFIG,
+        "a line bigger than the cache is rejected");
+  check(create_status(1024, 4, 3, 0, 0) == CACHESIM_INVALID_CONFIG,
+        "an unknown type is rejected");
+  check(create_status(1024, 4, 1, 2, 0) == CACHESIM_INVALID_CONFIG,
+        "an unknown policy is rejected");
+  check(create_status(1024, 4, 1, 0, 3) == CACHESIM_INVALID_CONFIG,
+        "an unknown index is rejected");
+}
+
+// Sends null pointers and addresses over 2^63 - 1.
+static void test_invalid_arguments(void) {
+  cachesim_config config = {1024, 4, 0, 0, 0};
+  cachesim_cache* cache = NULL;
+  cachesim_counters counters = {0, 0};
+  const uint64_t too_big[] = {1, UINT64_C(1) << 63};
+  uint8_t results[2] = {9, 9};
+
+  check(cachesim_create(NULL, &cache) == CACHESIM_INVALID_ARGUMENT,
+        "create without config is rejected");
+  check(cachesim_create(&config, NULL) == CACHESIM_INVALID_ARGUMENT,
+        "create without cache is rejected");
+  check(cachesim_simulate_batch(NULL, too_big, 1, results) ==
+            CACHESIM_INVALID_ARGUMENT,
+        "simulate without cache is rejected");
+  check(cachesim_get_counters(NULL, &counters) == CACHESIM_INVALID_ARGUMENT,
+        "counters without cache are rejected");
+  check(cachesim_reset(NULL) == CACHESIM_INVALID_ARGUMENT,
+        "reset without cache is rejected");
+  cachesim_destroy(NULL);
+
+  if (cachesim_create(&config, &cache) != CACHESIM_OK) {
+    check(0, "a direct-mapped cache is created");
+    return;
+  }
+  check(cachesim_simulate_batch(cache, NULL, 1, results) ==
+            CACHESIM_INVALID_ARGUMENT,
+        "simulate without addresses is rejected");
+  check(cachesim_simulate_batch(cache, too_big, 2, results) ==
+                CACHESIM_INVALID_ARGUMENT &&
+            results[0] == 9,
+        "an address over 2^63 - 1 rejects the whole batch");
+  check(cachesim_get_counters(cache, NULL) == CACHESIM_INVALID_ARGUMENT,
+        "counters without output are rejected");
+  check(cachesim_get_counters(cache, &counters) == CACHESIM_OK &&
+            counters.hits == 0 && counters.misses == 0,
+        "a rejected batch allocates nothing");
+  cachesim_destroy(cache);
+}
+
+// Main function
+int main(void) {
+  test_round_trip();
+  test_invalid_configs();
+  test_invalid_arguments();
+
+  printf(failures ? "capi_test failed\n" : "capi_test passed\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+#!/bin/sh
+# Copyright 2021 Juan Yaguaro
+# Command line tests of cachesim: runs bin/cachesim on small inputs and
+# compares its totals with the expected ones.
+# Run from the repository root, after make.
+
+CACHESIM=${CACHESIM:-bin/cachesim}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+# Prints the allocations, hits and misses totals of a run, one per line.
+totals() {
+  "$CACHESIM" "$@" | grep -E "Total cache (allocations|hits|misses):" |
+    awk '{ print $NF }'
+}
+
+# Counts a failure unless the totals of a run (first argument) are the
+# expected ones (second argument, "allocations hits misses" or the totals of
+# another run).
+expect() {
+  actual=$(echo $1)
+  expected=$(echo $2)
+  if [ "$actual" != "$expected" ]; then
+    echo "FAILED: $3: got \"$actual\", expected \"$expected\""
+    failures=$((failures + 1))
+  fi
+}
+
+# Config files: size, type, line size, policy.
+printf '1024\n1\n16\n0\n' > "$WORK/set_associative.txt"
+printf '64\n0\n16\n0\n' > "$WORK/direct.txt"
+
+# The sample traces hold the same 22 line accesses (7 distinct lines), in
+# Lackey and drmemtrace formats.
+for sample in "lackey docs/samples/lackey.trace" \
+              "drmemtrace docs/samples/drmemtrace.bin"; do
+  set -- $sample
+  expect "$(totals -c="$WORK/set_associative.txt" -d="$2" -f="$1")" \
+         "22 15 7" "$2 in a set-associative cache"
+  expect "$(totals -c="$WORK/direct.txt" -d="$2" -f="$1")" \
+         "22 9 13" "$2 in a direct-mapped cache"
+done
+
+# Corrupt records are skipped: an access too big, and accesses whose last
+# line doesn't fit in a non-negative address. A negative TEXT address ends
+# the data file.
+printf '64\n0\n1\n0\n' > "$WORK/byte_lines.txt"
+cat > "$WORK/corrupt.trace" <<EOF
+ L 1000,4
+ L 2000,4294967295
+ L ffffffffffffffff,1
+ L 7ffffffffffffffe,2
+ S fffffffffffffffe,4
+EOF
+expect "$(totals -c="$WORK/byte_lines.txt" -d="$WORK/corrupt.trace" \
+                 -f=lackey)" "6 0 6" "corrupt Lackey records"
+printf '5\n-3\n5\n' > "$WORK/negative.txt"
+expect "$(totals -c="$WORK/direct.txt" -d="$WORK/negative.txt")" "1 0 1" \
+       "a negative TEXT address"
+
+# A TLB level with entries and no ways is rejected.
+printf '4096\n0\n16\n4\n256\n' > "$WORK/dangling_tlb.txt"
+if ! "$CACHESIM" -c="$WORK/direct.txt" -d=docs/samples/lackey.trace \
+     -f=lackey -T="$WORK/dangling_tlb.txt" |
+     grep -q "Invalid input read in TLB config file"; then
+  echo "FAILED: a TLB level without ways is not rejected"
+  failures=$((failures + 1))
+fi
+
+# A shared cache whose second tenant allocates nothing behaves like a
+# set-associative cache running the first tenant alone.
+: > "$WORK/empty.txt"
+for policy in 0 1; do
+  for index in 0 1 2; do
+    printf '32\n1\n4\n%s\n%s\n' $policy $index > "$WORK/config.txt"
+    expect "$(totals -c="$WORK/config.txt" -d=docs/samples/lackey.trace \
+                     -d="$WORK/empty.txt" -f=lackey)" \
+           "$(totals -c="$WORK/config.txt" -d=docs/samples/lackey.trace \
+                     -f=lackey)" \
+           "a single tenant with policy $policy and index $index"
+  done
+done
+
+# A shared cache with an unknown policy or index is rejected.
+for config in "2 0" "-1 0" "0 3"; do
+  printf '32\n1\n4\n%s\n%s\n' $config > "$WORK/config.txt"
+  if ! "$CACHESIM" -c="$WORK/config.txt" -d=docs/samples/lackey.trace \
+       -d="$WORK/empty.txt" -f=lackey |
+       grep -q "Invalid cache type"; then
+    echo "FAILED: a shared cache with policy and index $config is not rejected"
+    failures=$((failures + 1))
+  fi
+done
+
+# Tenant options need several data files.
+for option in -r=2 -m=f -i=timestamps; do
+  if ! "$CACHESIM" -c="$WORK/set_associative.txt" \
+       -d=docs/samples/lackey.trace -f=lackey $option |
+       grep -q "need several data files"; then
+    echo "FAILED: $option with a single data file is not rejected"
+    failures=$((failures + 1))
+  fi
+done
+
+# Windows out of range are rejected before anything is simulated.
+for window in -1 0 2000000000; do
+  if ! "$CACHESIM" -c="$WORK/set_associative.txt" \
+       -d=docs/samples/lackey.trace -f=lackey -w=$window |
+       grep -q "Invalid argument"; then
+    echo "FAILED: -w=$window is not rejected"
+    failures=$((failures + 1))
+  fi
+done
+
+# The options of the windowed statistics need a window, and a stats file that
+# can't be opened stops the simulation.
+for option in -p=10 -s="$WORK/stats.csv"; do
+  if ! "$CACHESIM" -c="$WORK/set_associative.txt" \
+       -d=docs/samples/lackey.trace -f=lackey $option |
+       grep -q "need a window"; then
+    echo "FAILED: $option without -w is not rejected"
+    failures=$((failures + 1))
+  fi
+done
+if ! "$CACHESIM" -c="$WORK/set_associative.txt" -d=docs/samples/lackey.trace \
+     -f=lackey -w=5 -s="$WORK/missing/stats.csv" |
+     grep -q "Failed to open"; then
+  echo "FAILED: a stats file that can't be opened is not reported"
+  failures=$((failures + 1))
+fi
+
+if [ $failures -ne 0 ]; then
+  echo "cli_test failed"
+  exit 1
+fi
+echo "cli_test passed"
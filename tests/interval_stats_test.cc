@@ -0,0 +1,135 @@
+// Copyright 2021 Juan Yaguaro
+// Tests of the windowed statistics: the counters of every window, the ring
+// keeping the latest windows, the CSV output and the phase detection.
+#include <cachesim/interval_stats.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(const bool& condition, const std::string& what) {
+  if (!condition) {
+    std::cout << "FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+// Records a window of the given hits and misses, all of different addresses
+// starting at base.
+static void record_window(cachesim::interval_stats* stats,
+                          const std::uint32_t& hits,
+                          const std::uint32_t& misses,
+                          const std::int64_t& base = 0) {
+  for (std::uint32_t i = 0; i < hits + misses; ++i) {
+    stats->record(base + i, i < hits, false);
+  }
+}
+
+// Ten allocations in windows of 4 give two full windows and a partial one
+// closed by finish, each counting its own hits, misses, evictions and
+// distinct addresses.
+static void test_windows() {
+  cachesim::interval_stats stats(4);
+  const std::int64_t dirs[] = {1, 2, 1, 3, 3, 3, 3, 3, 7, 1};
+
+  for (std::size_t i = 0; i < 10; ++i) {
+    stats.record(dirs[i], i % 2, i == 5);
+  }
+  check(stats.size() == 2, "a partial window is kept open");
+  stats.finish();
+  check(stats.size() == 3, "finish closes the partial window");
+  stats.finish();
+  check(stats.size() == 3, "finish without allocations adds no window");
+
+  check(stats[0].first == 0 && stats[1].first == 4 && stats[2].first == 8,
+        "the windows start every 4 allocations");
+  check(stats[0].accesses == 4 && stats[2].accesses == 2,
+        "the last window holds the remaining allocations");
+  check(stats[0].hits == 2 && stats[0].misses == 2 && stats[2].hits == 1,
+        "hits and misses are counted per window");
+  check(stats[1].evictions == 1 && stats[0].evictions == 0,
+        "evictions are counted in their window");
+  check(stats[0].unique == 3 && stats[1].unique == 1 && stats[2].unique == 2,
+        "distinct addresses are counted per window");
+
+  cachesim::interval_stats large(1000);
+  record_window(&large, 0, 1000, -500);
+  check(large.size() == 1 && large[0].unique == 1000,
+        "a full window of distinct addresses counts them all");
+
+  cachesim::interval_stats single(0);
+  record_window(&single, 1, 1);
+  check(single.size() == 2, "a window of 0 allocations holds 1");
+}
+
+// A ring of 2 windows keeps the latest 2, oldest first.
+static void test_ring() {
+  cachesim::interval_stats stats(3, 0, 2);
+
+  for (int window = 0; window < 5; ++window) {
+    record_window(&stats, 1, 2, window * 10);
+  }
+  check(stats.size() == 2, "the ring keeps 2 windows");
+  check(stats[0].first == 9 && stats[1].first == 12,
+        "the ring keeps the latest windows, oldest first");
+}
+
+// The CSV holds a header and a row per window kept.
+static void test_csv() {
+  cachesim::interval_stats stats(4);
+  std::ostringstream os;
+
+  record_window(&stats, 3, 1);
+  record_window(&stats, 0, 2);
+  stats.finish();
+  stats.write_csv(os);
+  check(os.str() ==
+            "window,first_access,accesses,hits,misses,evictions,"
+            "unique_blocks,hit_rate,phase_change\n"
+            "0,0,4,3,1,0,4,0.75,1\n"
+            "1,4,2,0,2,0,2,0,0\n",
+        "the CSV holds every window");
+}
+
+// With a threshold of 0.25 a window starts a new phase when its hit rate is
+// more than 0.25 away from the mean of the current phase. Without a threshold
+// only the first window starts a phase.
+static void test_phases() {
+  cachesim::interval_stats stats(4, 0.25);
+  const std::uint32_t hits[] = {0, 1, 4, 4, 3, 0};
+  const bool changes[] = {true, false, true, false, false, true};
+
+  for (auto window_hits : hits) {
+    record_window(&stats, window_hits, 4 - window_hits);
+  }
+  check(stats.phase_count() == 3, "3 phases are detected");
+  for (std::size_t i = 0; i < stats.size(); ++i) {
+    check(stats[i].phase_change == changes[i],
+          "window " + std::to_string(i) + " phase change");
+  }
+
+  cachesim::interval_stats flat(4);
+  for (auto window_hits : hits) {
+    record_window(&flat, window_hits, 4 - window_hits);
+  }
+  check(flat.phase_count() == 1 && flat[0].phase_change &&
+            !flat[2].phase_change,
+        "without a threshold there is a single phase");
+}
+
+// Main function
+int main() {
+  test_windows();
+  test_ring();
+  test_csv();
+  test_phases();
+
+  std::cout << (failures ? "interval_stats_test failed\n"
+                         : "interval_stats_test passed\n");
+  return failures ? 1 : 0;
+}
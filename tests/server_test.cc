@@ -0,0 +1,324 @@
+// Copyright 2021 Juan Yaguaro
+// Protocol tests of the simulation server: a CREATE, ALLOCATE and COUNTERS
+// round trip, traces loaded and run, malformed frames, and clients stalled in
+// the middle of a frame.
+#include <cachesim/server.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// struct response
+// Status and payload of a response frame.
+struct response {
+  int status;              // status code, -1 if no response arrived
+  std::vector<char> data;  // response payload
+};
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(const bool& condition, const std::string& what) {
+  if (!condition) {
+    std::cout << "FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+// Connects to the server socket, retrying while the server starts.
+// Returns -1 if the server never listened.
+static int connect_to(const std::string& path) {
+  sockaddr_un addr{};
+
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    auto fd{::socket(AF_UNIX, SOCK_STREAM, 0)};
+    if (!::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))) {
+      return fd;
+    }
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return -1;
+}
+
+// Appends an integer to a payload.
+template <typename T>
+static void put(std::vector<char>* payload, const T& value) {
+  auto p{reinterpret_cast<const char*>(&value)};
+  payload->insert(payload->end(), p, p + sizeof(value));
+}
+
+// Appends a string to a payload.
+static void put_string(std::vector<char>* payload, const std::string& s) {
+  put(payload, static_cast<std::uint16_t>(s.size()));
+  payload->insert(payload->end(), s.begin(), s.end());
+}
+
+// Reads exactly n bytes. Returns false if the connection was closed before.
+static bool read_exactly(const int& fd, void* buf, std::size_t n) {
+  auto p{static_cast<char*>(buf)};
+
+  while (n) {
+    auto got{::read(fd, p, n)};
+    if (got <= 0) {
+      return false;
+    }
+    p += got;
+    n -= static_cast<std::size_t>(got);
+  }
+  return true;
+}
+
+// Sends a request frame and waits for its response.
+static response request(const int& fd, const std::uint8_t& code,
+                        const std::vector<char>& payload) {
+  std::vector<char> frame;
+  response r{-1, {}};
+  std::uint32_t length = 0;
+  std::uint8_t status = 0;
+
+  put(&frame, static_cast<std::uint32_t>(payload.size() + 1));
+  put(&frame, code);
+  frame.insert(frame.end(), payload.begin(), payload.end());
+  if (::write(fd, frame.data(), frame.size()) !=
+          static_cast<ssize_t>(frame.size()) ||
+      !read_exactly(fd, &length, sizeof(length)) || !length ||
+      !read_exactly(fd, &status, sizeof(status))) {
+    return r;
+  }
+  r.data.resize(length - 1);
+  if (read_exactly(fd, r.data.data(), r.data.size())) {
+    r.status = status;
+  }
+  return r;
+}
+
+// Returns the payload of a CREATE request.
+static std::vector<char> create_payload(const std::string& name,
+                                        const std::uint32_t& size,
+                                        const std::uint32_t& line_size) {
+  std::vector<char> payload;
+
+  put_string(&payload, name);
+  put(&payload, size);
+  put(&payload, std::uint32_t{cachesim::SET_ASSOCIATIVE});
+  put(&payload, line_size);
+  put(&payload, std::uint32_t{cachesim::LRU});
+  return payload;
+}
+
+// Returns whether the server closed the connection within the given time.
+static bool closed_within(const int& fd, const int& ms) {
+  pollfd watched{fd, POLLIN, 0};
+  char byte = 0;
+
+  return ::poll(&watched, 1, ms) == 1 && ::read(fd, &byte, 1) == 0;
+}
+
+// Creates a cache, allocates addresses in it and reads its counters back.
+static void test_round_trip(const int& fd) {
+  auto created{request(fd, cachesim::protocol::CREATE,
+                       create_payload("l1", 1024, 4))};
+  check(created.status == cachesim::protocol::OK, "CREATE answers OK");
+
+  std::vector<char> allocate;
+  put_string(&allocate, "l1");
+  put(&allocate, std::uint32_t{3});
+  for (std::int64_t value : {1, 2, 1}) {
+    put(&allocate, value);
+  }
+  auto allocated{request(fd, cachesim::protocol::ALLOCATE, allocate)};
+  check(allocated.status == cachesim::protocol::OK, "ALLOCATE answers OK");
+  check(allocated.data == std::vector<char>{0, 0, 1},
+        "ALLOCATE answers miss, miss, hit");
+
+  std::vector<char> name;
+  put_string(&name, "l1");
+  auto counters{request(fd, cachesim::protocol::COUNTERS, name)};
+  std::uint64_t values[2] = {0, 0};
+  check(counters.status == cachesim::protocol::OK &&
+            counters.data.size() == sizeof(values),
+        "COUNTERS answers two counters");
+  if (counters.data.size() == sizeof(values)) {
+    std::memcpy(values, counters.data.data(), sizeof(values));
+  }
+  check(values[0] == 1 && values[1] == 2, "COUNTERS answers 1 hit, 2 misses");
+}
+
+// Loads traces in the formats of the command line and runs them.
+static void test_load(const int& fd, const std::string& text_path) {
+  std::vector<char> lackey;
+  put_string(&lackey, "lackey");
+  put_string(&lackey, "docs/samples/lackey.trace");
+  put(&lackey, std::uint32_t{cachesim::LACKEY});
+  put(&lackey, std::uint32_t{16});
+  check(request(fd, cachesim::protocol::LOAD, lackey).status ==
+            cachesim::protocol::OK,
+        "LOAD of a Lackey trace answers OK");
+
+  std::vector<char> text;
+  put_string(&text, "text");
+  put_string(&text, text_path);
+  check(request(fd, cachesim::protocol::LOAD, text).status ==
+            cachesim::protocol::OK,
+        "LOAD of a text trace answers OK");
+
+  auto unknown_format{text};
+  put(&unknown_format, std::uint32_t{3});
+  check(request(fd, cachesim::protocol::LOAD, unknown_format).status ==
+            cachesim::protocol::BAD_REQUEST,
+        "LOAD with an unknown format answers BAD_REQUEST");
+
+  for (const std::string trace : {"lackey", "text"}) {
+    check(request(fd, cachesim::protocol::CREATE,
+                  create_payload(trace, 1024, 16))
+                  .status == cachesim::protocol::OK,
+          "CREATE answers OK");
+    std::vector<char> run;
+    put_string(&run, trace);
+    put_string(&run, trace);
+    auto ran{request(fd, cachesim::protocol::RUN, run)};
+    std::uint64_t values[2] = {0, 0};
+    if (ran.data.size() == sizeof(values)) {
+      std::memcpy(values, ran.data.data(), sizeof(values));
+    }
+    if (trace == "lackey") {
+      check(values[0] == 15 && values[1] == 7,
+            "RUN of the Lackey trace answers 15 hits, 7 misses");
+    } else {
+      check(values[0] == 1 && values[1] == 1,
+            "RUN of the text trace stops at its negative address");
+    }
+  }
+}
+
+// Sends requests the server must reject without dropping the connection.
+static void test_rejected_requests(const int& fd) {
+  check(request(fd, cachesim::protocol::CREATE, create_payload("z", 64, 0))
+                .status == cachesim::protocol::INVALID_CACHE,
+        "CREATE with line size 0 answers INVALID_CACHE");
+  check(request(fd, cachesim::protocol::CREATE, create_payload("z", 48, 4))
+                .status == cachesim::protocol::INVALID_CACHE,
+        "CREATE with a size not a power of 2 answers INVALID_CACHE");
+
+  auto unknown_index{create_payload("z", 1024, 4)};
+  put(&unknown_index, std::uint32_t{3});
+  check(request(fd, cachesim::protocol::CREATE, unknown_index).status ==
+            cachesim::protocol::INVALID_CACHE,
+        "CREATE with an unknown index answers INVALID_CACHE");
+  auto prime_index{create_payload("p", 1024, 4)};
+  put(&prime_index, std::uint32_t{cachesim::PRIME_MODULO});
+  check(request(fd, cachesim::protocol::CREATE, prime_index).status ==
+            cachesim::protocol::OK,
+        "CREATE with the prime modulo index answers OK");
+
+  auto truncated{create_payload("z", 1024, 4)};
+  truncated.resize(truncated.size() - 6);
+  check(request(fd, cachesim::protocol::CREATE, truncated).status ==
+            cachesim::protocol::BAD_REQUEST,
+        "truncated CREATE answers BAD_REQUEST");
+  check(request(fd, 99, {}).status == cachesim::protocol::UNKNOWN_OPCODE,
+        "unknown opcode answers UNKNOWN_OPCODE");
+
+  std::vector<char> name;
+  put_string(&name, "missing");
+  check(request(fd, cachesim::protocol::COUNTERS, name).status ==
+            cachesim::protocol::NO_SUCH_CACHE,
+        "COUNTERS of a missing cache answers NO_SUCH_CACHE");
+}
+
+// Sends a frame of length 0, which must close the connection.
+static void test_malformed_frame(const std::string& path) {
+  auto fd{connect_to(path)};
+  std::uint32_t length = 0;
+
+  check(::write(fd, &length, sizeof(length)) == sizeof(length) &&
+            closed_within(fd, 1000),
+        "a frame of length 0 closes the connection");
+  ::close(fd);
+}
+
+// Sends part of a frame and stops, which must close the connection once the
+// frame times out.
+static void test_stalled_client(const std::string& path) {
+  auto fd{connect_to(path)};
+  char byte = 8;
+
+  check(::write(fd, &byte, 1) == 1 &&
+            closed_within(fd, 2 * cachesim::protocol::frame_timeout_ms),
+        "a stalled frame closes the connection");
+  ::close(fd);
+}
+
+// Main function
+int main() {
+  std::string path("/tmp/cachesim_server_test_" + std::to_string(::getpid()) +
+                   ".sock");
+  // A socket left behind by a server that is gone must be replaced.
+  sockaddr_un stale{};
+  stale.sun_family = AF_UNIX;
+  std::strncpy(stale.sun_path, path.c_str(), sizeof(stale.sun_path) - 1);
+  auto stale_fd{::socket(AF_UNIX, SOCK_STREAM, 0)};
+  check(!::bind(stale_fd, reinterpret_cast<sockaddr*>(&stale), sizeof(stale)),
+        "a stale socket is left behind");
+  ::close(stale_fd);
+
+  cachesim::server simulation_server(path, 2);
+  auto started{false};
+  std::thread runner([&] { started = simulation_server.run(); });
+
+  std::string text_path(path + ".txt");
+  std::ofstream(text_path) << "5\n5\n-3\n5\n";
+
+  auto fd{connect_to(path)};
+  check(fd >= 0, "the server listens");
+  if (fd >= 0) {
+    struct stat st {};
+    check(::stat(path.c_str(), &st) == 0 && (st.st_mode & 0777) == 0600,
+          "the socket is only accessible by its user");
+    cachesim::server second(path, 1);
+    check(!second.run(), "a second server refuses a listened socket");
+    test_round_trip(fd);
+    test_rejected_requests(fd);
+    test_load(fd, text_path);
+    test_malformed_frame(path);
+    test_stalled_client(path);
+
+    // A client stalled in the middle of a frame must not delay the shutdown.
+    auto stalled{connect_to(path)};
+    char byte = 8;
+    check(::write(stalled, &byte, 1) == 1, "a stalled frame is sent");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto begin{std::chrono::steady_clock::now()};
+    check(request(fd, cachesim::protocol::SHUTDOWN, {}).status ==
+              cachesim::protocol::OK,
+          "SHUTDOWN answers OK");
+    runner.join();
+    auto elapsed{std::chrono::steady_clock::now() - begin};
+    check(elapsed < std::chrono::milliseconds(
+                        cachesim::protocol::frame_timeout_ms / 2),
+          "SHUTDOWN interrupts a stalled frame");
+    ::close(stalled);
+    ::close(fd);
+  } else {
+    runner.join();
+  }
+  check(started, "the server ran");
+  std::remove(text_path.c_str());
+
+  std::cout << (failures ? "server_test failed\n" : "server_test passed\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+// Copyright 2021 Juan Yaguaro
+// Tests of the set index functions: the set and tag of every policy, the
+// addresses rebuilt from them, the skews of XOR_FOLD, and a skewed-associative
+// cache whose ways spread the addresses conflicting in a set-associative one.
+#include <cachesim/cache.h>
+#include <cachesim/set_index.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(const bool& condition, const std::string& what) {
+  if (!condition) {
+    std::cout << "FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+// Returns addresses spread over the 64-bit range: small ones, multiples of
+// the set counts, and large ones up to 2^63 - 1.
+static std::vector<std::uint64_t> sample_addresses() {
+  std::vector<std::uint64_t> addresses;
+
+  for (std::uint64_t value = 0; value < 300; ++value) {
+    addresses.push_back(value);
+  }
+  for (unsigned shift = 8; shift < 63; ++shift) {
+    auto power{std::uint64_t{1} << shift};
+    addresses.push_back(power);
+    addresses.push_back(power - 1);
+    addresses.push_back(power + 0x9e37);
+  }
+  addresses.push_back(0x7fffffffffffffff);
+  return addresses;
+}
+
+// Checks, for every sample address, that the set is in range and that the
+// address is rebuilt from its set and its tag.
+static void check_round_trip(const cachesim::set_index& index,
+                             const std::string& name) {
+  for (auto value : sample_addresses()) {
+    auto set{index(value)};
+    if (set >= index.count() || index.rebuild(index.tag(value), set) != value) {
+      check(false, name + " maps and rebuilds " + std::to_string(value));
+      return;
+    }
+  }
+}
+
+// MODULO maps to address % count, also for set counts not powers of 2.
+static void test_modulo() {
+  for (std::size_t count : {1, 16, 24, 64}) {
+    cachesim::set_index index(cachesim::MODULO, count);
+    auto name{"MODULO " + std::to_string(count)};
+    check(index(1000) == 1000 % count && index.tag(1000) == 1000 / count,
+          name + " maps 1000 to its remainder");
+    check_round_trip(index, name);
+  }
+  check(cachesim::set_index(static_cast<cachesim::index_policy>(7), 16)
+                .policy() == cachesim::MODULO,
+        "an unknown policy falls back to MODULO");
+  check(cachesim::set_index(cachesim::MODULO, 16).tag_bits(32) == 28,
+        "16 sets leave 28 tag bits of a 32-bit address");
+}
+
+// XOR_FOLD leaves addresses below the set count in place, rebuilds every
+// address for every skew, and gives a different function for every skew.
+static void test_xor_fold() {
+  for (std::size_t count : {16, 24, 64, 1000}) {
+    for (std::size_t skew = 0; skew < cachesim::skew_count; ++skew) {
+      cachesim::set_index index(cachesim::XOR_FOLD, count, skew);
+      auto name{"XOR_FOLD " + std::to_string(count) + " skew " +
+                std::to_string(skew)};
+      check(index(count - 1) == count - 1,
+            name + " keeps an address below the count in its set");
+      check_round_trip(index, name);
+    }
+  }
+
+  cachesim::set_index plain(cachesim::XOR_FOLD, 64, 0);
+  cachesim::set_index skewed(cachesim::XOR_FOLD, 64, 1);
+  auto differ{0};
+  for (std::uint64_t value = 0; value < 64 * 64; value += 64) {
+    differ += plain(value) != skewed(value);
+  }
+  check(differ > 32, "skews 0 and 1 map most stride 64 addresses apart");
+
+  std::vector<bool> used(64, false);
+  for (std::uint64_t value = 0; value < 64 * 64; value += 64) {
+    used[plain(value)] = true;
+  }
+  auto sets{0};
+  for (auto set_used : used) {
+    sets += set_used;
+  }
+  check(sets > 1, "XOR_FOLD spreads stride 64 addresses over several sets");
+}
+
+// PRIME_MODULO maps to address % p, where p is the largest prime not greater
+// than the set count.
+static void test_prime_modulo() {
+  cachesim::set_index index(cachesim::PRIME_MODULO, 64);
+
+  check(index(61) == 0 && index(60) == 60 && index.tag(122) == 2,
+        "PRIME_MODULO 64 divides by 61");
+  check(index.tag_bits(32) == 27, "61 sets leave 27 tag bits");
+  check_round_trip(index, "PRIME_MODULO 64");
+  check_round_trip(cachesim::set_index(cachesim::PRIME_MODULO, 1),
+                   "PRIME_MODULO 1");
+}
+
+// Returns the hits of a cache cycling through addresses a number of times.
+static std::uint64_t cycle_hits(cachesim::cache* cache,
+                                const std::vector<std::uint64_t>& addresses,
+                                const int& rounds) {
+  for (auto round = 0; round < rounds; ++round) {
+    for (auto value : addresses) {
+      cache->allocate(static_cast<cachesim::address>(value));
+    }
+  }
+  return cache->hit_count();
+}
+
+// Five addresses conflicting in a 4-way set thrash a set-associative cache
+// of 4 sets, while the skewed ways of a skewed-associative cache of the same
+// size keep some of them.
+static void test_skewed_cache() {
+  std::ostringstream os;
+  std::vector<std::uint64_t> addresses{0, 4, 8, 12, 16};
+
+  auto set_associative{cachesim::make_cache(16, cachesim::SET_ASSOCIATIVE, 1,
+                                            cachesim::LRU, cachesim::MODULO,
+                                            os, false)};
+  auto skewed{cachesim::make_cache(16, cachesim::SKEWED_ASSOCIATIVE, 1,
+                                   cachesim::LRU, cachesim::MODULO, os,
+                                   false)};
+  check(set_associative && skewed, "both caches are made");
+  if (!set_associative || !skewed) {
+    return;
+  }
+  set_associative->set_quiet(true);
+  skewed->set_quiet(true);
+  check(cycle_hits(set_associative.get(), addresses, 4) == 0,
+        "conflicting addresses thrash a set-associative cache");
+  check(cycle_hits(skewed.get(), addresses, 4) > 0,
+        "a skewed-associative cache keeps conflicting addresses");
+  check(cachesim::make_cache(16, cachesim::DIRECT, 1, cachesim::LRU, 3, os,
+                             false) == nullptr,
+        "an unknown index policy makes no cache");
+}
+
+// Main function
+int main() {
+  test_modulo();
+  test_xor_fold();
+  test_prime_modulo();
+  test_skewed_cache();
+
+  std::cout << (failures ? "set_index_test failed\n"
+                         : "set_index_test passed\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+// Copyright 2021 Juan Yaguaro
+// Tests of the conflict analysis: the count-min sketch estimates, the items
+// kept by heavy_hitters, and the blocks, sets and pairs counted by
+// conflict_stats.
+#include <cachesim/conflict_stats.h>
+#include <cachesim/sketch.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(const bool& condition, const std::string& what) {
+  if (!condition) {
+    std::cout << "FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+// A wide sketch counts a few keys exactly. A narrow one overcounts, but never
+// undercounts, any key.
+static void test_sketch() {
+  cachesim::count_min_sketch wide;
+
+  for (std::uint64_t key = 0; key < 10; ++key) {
+    for (std::uint64_t i = 0; i <= key; ++i) {
+      wide.add(key * 4096);
+    }
+  }
+  auto exact{true};
+  for (std::uint64_t key = 0; key < 10; ++key) {
+    exact = exact && wide.estimate(key * 4096) == key + 1;
+  }
+  check(exact, "a wide sketch counts a few keys exactly");
+  check(wide.estimate(7) == 0, "a key never added is estimated at 0");
+  check(wide.add(0) == 2, "add returns the new estimate");
+  wide.clear();
+  check(wide.estimate(4096) == 0, "clear zeroes the counters");
+
+  cachesim::count_min_sketch narrow(16);
+  std::vector<std::uint64_t> counts(1000, 0);
+  for (std::uint64_t i = 0; i < 20000; ++i) {
+    auto key{i % 7 ? i % 1000 : i % 3};
+    ++counts[key];
+    narrow.add(key);
+  }
+  auto never_under{true};
+  for (std::uint64_t key = 0; key < 1000; ++key) {
+    never_under = never_under && narrow.estimate(key) >= counts[key];
+  }
+  check(never_under, "a narrow sketch never undercounts");
+}
+
+// The k most frequent keys are kept, highest count first, among many rare
+// ones, also when they appear after the rare ones filled the items kept.
+static void test_heavy_hitters() {
+  cachesim::heavy_hitters<int> hitters(3);
+  const std::uint64_t keys[] = {11, 22, 33};
+  const int times[] = {60, 40, 20};
+
+  for (std::uint64_t rare = 1000; rare < 1500; ++rare) {
+    hitters.add(rare, -1);
+  }
+  for (int round = 0; round < 60; ++round) {
+    for (std::size_t i = 0; i < 3; ++i) {
+      if (round < times[i]) {
+        hitters.add(keys[i], static_cast<int>(keys[i]));
+      }
+    }
+    hitters.add(2000 + round, -1);
+  }
+
+  auto top{hitters.top()};
+  check(hitters.total() == 500 + 60 + 40 + 20 + 60,
+        "every addition is counted");
+  check(top.size() == 3, "3 items are kept");
+  if (top.size() == 3) {
+    check(top[0].item == 11 && top[1].item == 22 && top[2].item == 33,
+          "the most frequent keys are kept, highest count first");
+    check(top[0].count >= 60 && top[1].count >= 40 && top[2].count >= 20,
+          "the counts are not undercounted");
+  }
+  hitters.clear();
+  check(hitters.total() == 0 && hitters.top().empty(),
+        "clear forgets every item");
+  check(cachesim::heavy_hitters<int>(0).capacity() == 1,
+        "at least one item is kept");
+}
+
+// Hits are ignored, a miss counts its block, and a miss evicting a block
+// counts its set and the pair of blocks, the lowest one first.
+static void test_conflict_stats() {
+  cachesim::conflict_stats conflicts(4);
+
+  conflicts.record(5, true, 0, -1);
+  check(conflicts.miss_count() == 0, "hits are ignored");
+  conflicts.record(5, false, 1, -1);
+  check(conflicts.miss_count() == 1 && conflicts.eviction_count() == 0,
+        "a miss without eviction only counts the block");
+  for (int i = 0; i < 3; ++i) {
+    conflicts.record(9, false, 1, 5);
+    conflicts.record(5, false, 1, 9);
+  }
+  conflicts.record(12, false, 2, 4);
+
+  auto blocks{conflicts.missing_blocks()};
+  auto sets{conflicts.thrashed_sets()};
+  auto pairs{conflicts.evicting_pairs()};
+  check(conflicts.miss_count() == 8 && conflicts.eviction_count() == 7,
+        "misses and evictions are counted");
+  check(!blocks.empty() && blocks[0].item == 5 && blocks[0].count == 4,
+        "block 5 misses most");
+  check(sets.size() == 2 && sets[0].item == 1 && sets[0].count == 6,
+        "set 1 evicts most");
+  check(pairs.size() == 2 && pairs[0].item.first == 5 &&
+            pairs[0].item.second == 9 && pairs[0].count == 6 &&
+            pairs[1].item.first == 4 && pairs[1].item.second == 12,
+        "pairs are counted lowest block first");
+}
+
+// Main function
+int main() {
+  test_sketch();
+  test_heavy_hitters();
+  test_conflict_stats();
+
+  std::cout << (failures ? "sketch_test failed\n" : "sketch_test passed\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+// Copyright 2021 Juan Yaguaro
+// Tests of the tag array: the width chosen for the tag bits, the widening on
+// a tag that doesn't fit, the tag search, and the scan of the validity bitmap
+// against a line by line scan.
+#include <cachesim/tag_array.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(const bool& condition, const std::string& what) {
+  if (!condition) {
+    std::cout << "FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+// The narrowest width holding the tag bits is chosen.
+static void test_widths() {
+  const unsigned bits[] = {1, 8, 9, 16, 17, 32, 33, 64};
+  const std::size_t widths[] = {1, 1, 2, 2, 4, 4, 8, 8};
+
+  for (std::size_t i = 0; i < 8; ++i) {
+    check(cachesim::tag_array(4, bits[i]).width() == widths[i],
+          std::to_string(bits[i]) + " bits are stored in " +
+              std::to_string(widths[i]) + " bytes");
+  }
+}
+
+// A tag wider than the array widens every tag, keeping their values and
+// their validity.
+static void test_widen() {
+  cachesim::tag_array tags(10, 8);
+
+  for (std::size_t i = 0; i < 10; ++i) {
+    if (i != 5) {
+      tags.set(i, i * 25);
+    }
+  }
+  check(tags.find(0, 10, 0x1234) == 10, "a wider tag is not found");
+  tags.set(3, 0x1234);
+  check(tags.width() == 2, "a 13-bit tag widens the array to 16 bits");
+  tags.set(4, std::uint64_t{1} << 40);
+  check(tags.width() == 8, "a 41-bit tag widens the array to 64 bits");
+  check(tags[3] == 0x1234 && tags[4] == std::uint64_t{1} << 40,
+        "the wide tags are stored");
+
+  auto kept{true};
+  for (std::size_t i = 0; i < 10; ++i) {
+    if (i != 3 && i != 4 && i != 5) {
+      kept = kept && tags.valid(i) && tags[i] == i * 25;
+    }
+  }
+  check(kept, "widening keeps the other tags");
+  check(!tags.valid(5), "widening keeps an invalid line invalid");
+  check(tags.find(2, 3, std::uint64_t{1} << 40) == 2,
+        "a wide tag is found from an offset");
+  check(tags.find(0, 3, 50) == 2 && tags.find(0, 2, 50) == 2,
+        "a tag is only found among the n tags searched");
+
+  tags.clear();
+  check(!tags.valid(0) && !tags.valid(9) && tags.width() == 8,
+        "clear invalidates every line and keeps the width");
+}
+
+// Rotating a run of tags moves the middle one first.
+static void test_rotate() {
+  cachesim::tag_array tags(6, 8);
+
+  for (std::size_t i = 0; i < 6; ++i) {
+    tags.set(i, i);
+  }
+  tags.rotate(1, 3, 5);
+  check(tags[0] == 0 && tags[1] == 3 && tags[2] == 4 && tags[3] == 1 &&
+            tags[4] == 2 && tags[5] == 5,
+        "rotate moves [1, 5) to start at 3");
+}
+
+// Returns the position of the first invalid line among the n lines from
+// first, scanning line by line.
+static std::size_t naive_find_empty(const cachesim::tag_array& tags,
+                                    const std::size_t& first,
+                                    const std::size_t& n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (!tags.valid(first + i)) {
+      return i;
+    }
+  }
+  return n;
+}
+
+// The word at a time scan answers like the line by line one for every run of
+// lines, over bitmaps crossing several words, full words and empty words.
+static void test_find_empty() {
+  const std::size_t size = 200;
+  cachesim::tag_array tags(size, 8);
+  std::uint64_t state = 0x9e3779b97f4a7c15;
+
+  for (std::size_t i = 0; i < size; ++i) {
+    state = state * 6364136223846793005 + 1442695040888963407;
+    if ((i >= 64 && i < 128) || (i >= 150 && state >> 62)) {
+      tags.set(i, 1);
+    } else if (i < 64 && state >> 63) {
+      tags.set(i, 1);
+    }
+  }
+  for (std::size_t first = 0; first < size; ++first) {
+    for (std::size_t n = 0; first + n <= size; ++n) {
+      if (tags.find_empty(first, n) != naive_find_empty(tags, first, n)) {
+        check(false, "find_empty from " + std::to_string(first) + " over " +
+                         std::to_string(n) + " lines");
+        return;
+      }
+    }
+  }
+
+  cachesim::tag_array full(128, 8);
+  for (std::size_t i = 0; i < 128; ++i) {
+    full.set(i, i);
+  }
+  check(full.find_empty(0, 128) == 128 && full.find_empty(60, 10) == 10,
+        "a full bitmap has no empty line");
+}
+
+// Main function
+int main() {
+  test_widths();
+  test_widen();
+  test_rotate();
+  test_find_empty();
+
+  std::cout << (failures ? "tag_array_test failed\n"
+                         : "tag_array_test passed\n");
+  return failures ? 1 : 0;
+}
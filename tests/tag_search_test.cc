@@ -0,0 +1,105 @@
+// Copyright 2021 Juan Yaguaro
+// Differential tests of the tag search kernels: the SSE4.2 and AVX2 kernels
+// the CPU supports must answer like the scalar kernel for every tag width,
+// array length (full vectors, partial vectors and tails) and match position.
+#include <cachesim/tag_search.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Longest array searched, enough for two full AVX2 steps of 8-bit tags and a
+// tail.
+constexpr const std::size_t max_tags = 70;
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(const bool& condition, const std::string& what) {
+  if (!condition) {
+    std::cout << "FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+// Searches the first n tags of the array with the kernel and the scalar
+// kernel, counting a failure if their answers differ.
+template <typename T, typename Kernel>
+static void compare(const Kernel& kernel, const std::string& name,
+                    const std::vector<T>& tags, const std::size_t& n,
+                    const T& tag, const std::string& what) {
+  auto expected{cachesim::simd::find_scalar(tags.data() + 1, n, tag)};
+  auto actual{kernel(tags.data() + 1, n, tag)};
+
+  check(actual == expected, name + " " + std::to_string(sizeof(T) * 8) +
+                                "-bit, n = " + std::to_string(n) + ", " +
+                                what + ": got " + std::to_string(actual) +
+                                ", expected " + std::to_string(expected));
+}
+
+// Runs the kernel over every length up to max_tags. The tags start one
+// element into the array, so that the vector loads are unaligned.
+// For each length the key is searched absent, at every position, repeated
+// after its first position, and as the neighbour of tags that only differ in
+// their sign bit or in their high bytes.
+template <typename T, typename Kernel>
+static void test_kernel(const Kernel& kernel, const std::string& name) {
+  const T key = static_cast<T>(0x5a);
+  const T sign = std::numeric_limits<T>::min();
+  const T high = static_cast<T>(key + (T{1} << (sizeof(T) * 8 - 2)));
+
+  for (std::size_t n = 0; n <= max_tags; ++n) {
+    std::vector<T> tags(max_tags + 2);
+    for (std::size_t i = 0; i < tags.size(); ++i) {
+      tags[i] = static_cast<T>(i % 3 ? sign | key : high);
+    }
+    // The key is only past the end of the searched tags.
+    tags[n + 1] = key;
+    compare(kernel, name, tags, n, key, "absent");
+    compare(kernel, name, tags, n, T{0}, "zero absent");
+
+    for (std::size_t position = 0; position < n; ++position) {
+      auto found{tags};
+      found[position + 1] = key;
+      compare(kernel, name, found, n, key,
+              "at " + std::to_string(position));
+      for (std::size_t i = position + 1; i < n; i += 5) {
+        found[i + 1] = key;
+      }
+      compare(kernel, name, found, n, key,
+              "first of several at " + std::to_string(position));
+    }
+  }
+}
+
+// Runs the kernels of an instruction set for every tag width.
+static void test_isa(const cachesim::simd::isa& set, const std::string& name) {
+  test_kernel<std::int8_t>(cachesim::simd::select_find8(set), name);
+  test_kernel<std::int16_t>(cachesim::simd::select_find16(set), name);
+  test_kernel<std::int32_t>(cachesim::simd::select_find32(set), name);
+  test_kernel<std::int64_t>(cachesim::simd::select_find64(set), name);
+}
+
+// Main function
+int main() {
+  auto supported{cachesim::simd::detect_isa()};
+
+  test_isa(cachesim::simd::SCALAR, "scalar");
+  if (supported >= cachesim::simd::SSE42) {
+    test_isa(cachesim::simd::SSE42, "SSE4.2");
+  } else {
+    std::cout << "SSE4.2 not supported, skipped\n";
+  }
+  if (supported >= cachesim::simd::AVX2) {
+    test_isa(cachesim::simd::AVX2, "AVX2");
+  } else {
+    std::cout << "AVX2 not supported, skipped\n";
+  }
+
+  std::cout << (failures ? "tag_search_test failed\n"
+                         : "tag_search_test passed\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+// Copyright 2021 Juan Yaguaro
+// Tests of the TLB: the configs it rejects, the page table entries read by a
+// page walk, the lookups of every level and the replacement policies.
+#include <cachesim/tlb.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(const bool& condition, const std::string& what) {
+  if (!condition) {
+    std::cout << "FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+// Returns whether a TLB of the given page size and policy is rejected.
+static bool rejected(const std::size_t& page_size, const int& policy) {
+  try {
+    cachesim::tlb tlb(page_size, policy);
+  } catch (const std::invalid_argument& e) {
+    return true;
+  }
+  return false;
+}
+
+// Translates an address, appending the page table entries read, if any, to
+// entries. The entries hit in the cache when hit is true.
+static bool translate(cachesim::tlb* tlb, const std::uint64_t& value,
+                      std::vector<std::uint64_t>* entries = nullptr,
+                      const bool& hit = false) {
+  return tlb->translate(value, [&](const std::uint64_t& entry) {
+    if (entries) {
+      entries->push_back(entry);
+    }
+    return hit;
+  });
+}
+
+// Page sizes must be powers of 2 from 4K to 1G, and levels a whole number of
+// sets.
+static void test_configs() {
+  check(rejected(2048, cachesim::LRU), "2K pages are rejected");
+  check(rejected(12288, cachesim::LRU), "12K pages are rejected");
+  check(rejected(std::size_t{1} << 31, cachesim::LRU),
+        "2G pages are rejected");
+  check(rejected(4096, 2), "an unknown policy is rejected");
+  check(!rejected(4096, cachesim::MRU) && !rejected(1 << 30, cachesim::LRU),
+        "4K and 1G pages are accepted");
+
+  cachesim::tlb tlb(4096, cachesim::LRU);
+  check(!tlb.add_level(0, 4) && !tlb.add_level(16, 0) &&
+            !tlb.add_level(12, 8),
+        "levels without entries, without ways or with a partial set are "
+        "rejected");
+  check(tlb.add_level(12, 4) && tlb.level_count() == 1,
+        "a level of 3 sets of 4 ways is added");
+}
+
+// A walk reads one entry per 9 bits of the page number, root first, each
+// level of the page table in its own region.
+static void test_walk() {
+  const std::uint64_t value = 0x123456789abc;
+  const std::uint64_t base = cachesim::page_table_base;
+  const std::uint64_t region = cachesim::page_table_region;
+  std::vector<std::uint64_t> entries;
+
+  check(cachesim::tlb(4096, 0).walk_depth() == 4 &&
+            cachesim::tlb(1 << 21, 0).walk_depth() == 3 &&
+            cachesim::tlb(1 << 30, 0).walk_depth() == 2,
+        "4K, 2M and 1G pages walk 4, 3 and 2 levels");
+
+  cachesim::tlb tlb(4096, cachesim::LRU);
+  check(!translate(&tlb, value, &entries), "a TLB without levels misses");
+  check(entries == std::vector<std::uint64_t>{base + (value >> 39) * 8,
+                                              base + region +
+                                                  (value >> 30) * 8,
+                                              base + 2 * region +
+                                                  (value >> 21) * 8,
+                                              base + 3 * region +
+                                                  (value >> 12) * 8},
+        "a 4K walk reads the entry of every level, root first");
+
+  cachesim::tlb huge(1 << 30, cachesim::LRU);
+  entries.clear();
+  translate(&huge, value, &entries);
+  check(entries == std::vector<std::uint64_t>{base + (value >> 39) * 8,
+                                              base + region +
+                                                  (value >> 30) * 8},
+        "a 1G walk reads 2 entries");
+
+  translate(&tlb, value, nullptr, true);
+  translate(&tlb, value << 16, nullptr, false);
+  check(tlb.walk_count() == 3 && tlb.walk_access_count() == 12 &&
+            tlb.walk_miss_count() == 8,
+        "walks count the entries read and the entries missed");
+}
+
+// A translation found in the second level is copied into the first one, and
+// offsets inside a page share its translation.
+static void test_levels() {
+  cachesim::tlb tlb(4096, cachesim::LRU);
+  tlb.add_level(2, 1);
+  tlb.add_level(8, 8);
+
+  check(!translate(&tlb, 0x1000) && tlb.walk_count() == 1,
+        "a first translation walks");
+  check(translate(&tlb, 0x1fff) && tlb.walk_count() == 1,
+        "an offset in the same page hits the first level");
+  translate(&tlb, 0x3000);  // the same set of the first level
+  check(translate(&tlb, 0x1000) && tlb.walk_count() == 2,
+        "an evicted translation hits the second level");
+  check(tlb.counters(0).hits == 1 && tlb.counters(0).misses == 3 &&
+            tlb.counters(1).hits == 1 && tlb.counters(1).misses == 2,
+        "every level counts its lookups");
+  check(translate(&tlb, 0x1000) && tlb.counters(0).hits == 2,
+        "a translation found in the second level fills the first");
+}
+
+// In a set of 2 ways, LRU replaces the translation used least recently and
+// MRU the one used most recently.
+static void test_policies() {
+  cachesim::tlb lru(4096, cachesim::LRU);
+  cachesim::tlb mru(4096, cachesim::MRU);
+  lru.add_level(2, 2);
+  mru.add_level(2, 2);
+
+  for (auto page : {0xa, 0xb, 0xa, 0xc}) {
+    translate(&lru, page << 12);
+    translate(&mru, page << 12);
+  }
+  check(translate(&lru, 0xa << 12) && !translate(&lru, 0xb << 12),
+        "LRU replaces the least recently used translation");
+  check(translate(&mru, 0xb << 12) && !translate(&mru, 0xa << 12),
+        "MRU replaces the most recently used translation");
+}
+
+// Main function
+int main() {
+  test_configs();
+  test_walk();
+  test_levels();
+  test_policies();
+
+  std::cout << (failures ? "tlb_test failed\n" : "tlb_test passed\n");
+  return failures ? 1 : 0;
+}
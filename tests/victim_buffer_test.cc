@@ -0,0 +1,107 @@
+// Copyright 2021 Juan Yaguaro
+// Tests of the victim and miss caches: the lines every mode receives, the
+// least recently used line replaced, and a direct-mapped cache recovering
+// conflict misses through its buffer.
+#include <cachesim/direct_cache.h>
+#include <cachesim/victim_buffer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static int failures = 0;
+
+// Counts a failure, printing what was expected, unless the condition holds.
+static void check(const bool& condition, const std::string& what) {
+  if (!condition) {
+    std::cout << "FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+// Buffers hold up to max_buffer_lines lines, and a buffer without lines never
+// holds anything.
+static void test_sizes() {
+  check(cachesim::victim_buffer(100, cachesim::VICTIM).size() ==
+            cachesim::max_buffer_lines,
+        "a buffer holds up to max_buffer_lines lines");
+
+  cachesim::victim_buffer empty;
+  empty.probe(1, 2);
+  check(empty.size() == 0 && !empty.probe(2, 3) && empty.hit_count() == 0,
+        "a buffer without lines never hits");
+}
+
+// A victim cache receives the evicted lines, and a line found in it leaves
+// the buffer, swapped with the line evicted to hold it.
+static void test_victim() {
+  cachesim::victim_buffer buffer(2, cachesim::VICTIM);
+
+  check(!buffer.probe(10, cachesim::empty_space),
+        "a miss without eviction finds nothing");
+  check(!buffer.probe(10, cachesim::empty_space),
+        "a missing line is not put in a victim cache");
+  check(!buffer.probe(20, 10), "an evicted line is not found at once");
+  check(buffer.probe(10, 20) && buffer.hit_count() == 1,
+        "an evicted line is found");
+  check(!buffer.probe(10, 30), "a line found is swapped out of the buffer");
+  check(buffer.probe(20, 40), "the line evicted by a swap is kept");
+
+  buffer.probe(50, 60);
+  check(!buffer.probe(30, 70) && buffer.probe(60, 80),
+        "the least recently used line is replaced");
+  buffer.clear();
+  check(buffer.hit_count() == 0 && !buffer.probe(80, 90),
+        "clear empties the buffer and zeroes its counter");
+}
+
+// A miss cache receives a copy of every missing line and keeps the lines
+// found in it.
+static void test_miss() {
+  cachesim::victim_buffer buffer(2, cachesim::MISS);
+
+  check(!buffer.probe(10, 99), "a first miss finds nothing");
+  check(buffer.probe(10, cachesim::empty_space) &&
+            buffer.probe(10, cachesim::empty_space),
+        "a line found in a miss cache is kept");
+  buffer.probe(20, cachesim::empty_space);
+  check(!buffer.probe(99, cachesim::empty_space),
+        "evicted lines are not put in a miss cache");
+  check(!buffer.probe(10, cachesim::empty_space) &&
+            buffer.hit_count() == 2,
+        "the least recently used line is replaced");
+}
+
+// Two addresses thrashing a line of a direct-mapped cache keep missing in
+// it, but the misses after the first two are found in its buffer.
+static void test_direct_cache() {
+  std::ostringstream os;
+
+  for (auto mode : {cachesim::VICTIM, cachesim::MISS}) {
+    cachesim::direct_cache cache(4, 1, cachesim::LRU, os, false);
+    cache.set_quiet(true);
+    cache.set_buffer(2, mode);
+    for (int i = 0; i < 8; ++i) {
+      cache.allocate(i % 2 ? 4 : 0);
+    }
+    check(cache.miss_count() == 8 && cache.buffer().hit_count() == 6,
+          std::string(mode == cachesim::VICTIM ? "a victim" : "a miss") +
+              " cache recovers the conflict misses");
+    cache.clear();
+    check(cache.buffer().hit_count() == 0, "clear empties the buffer");
+  }
+}
+
+// Main function
+int main() {
+  test_sizes();
+  test_victim();
+  test_miss();
+  test_direct_cache();
+
+  std::cout << (failures ? "victim_buffer_test failed\n"
+                         : "victim_buffer_test passed\n");
+  return failures ? 1 : 0;
+}